@@ -0,0 +1,6 @@
+#version 450 core
+
+// Depth only, the color writes are masked off while the pre-pass runs
+void main(void)
+{
+}
@@ -0,0 +1,27 @@
+#version 450 core
+
+// Position only version of vShader.glsl for the depth pre-pass and the overdraw view.
+// The main pass tests against this depth with GL_EQUAL, so gl_Position has to be computed
+// exactly like it is there, keep the two insync
+layout(location = 0) in vec3 position;
+layout(location = 4) in uint drawId;
+
+invariant gl_Position;
+
+#include "frameData.glsl"
+
+struct ObjectData {
+	mat4 toWorld;
+	mat4 modelMatrix;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+};
+
+void main(void)
+{
+	mat4 toWorld = objects[drawId].toWorld * objects[drawId].modelMatrix;
+
+	gl_Position = toProjection * toCamera * toWorld * vec4(position, 1.0f);
+}
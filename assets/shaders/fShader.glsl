@@ -1,27 +1,49 @@
 #version 450 core
 
-#define NUM_OF_LIGHTS 1
-
-
-struct LightSource
-{
-	vec3 tanPos;
-};
-
-
-
 // From the vertex shader
 in Vertex {
     		vec3 thePosition;
 		vec2 theTexCoord;
 		vec3 theNormal;
 		vec3 tangentPos;
+		mat3 TBN;
 } v;
 
+in vec3 tanCamPos;
+
+// Keep insync with LightUniforms in headers/Core/Renderer.h
+struct Light {
+	vec4 position;
+	vec4 diffuse;
+	vec4 specular;
+};
 
+layout(std430, binding = 2) readonly buffer LightBuffer {
+	Light lights[];
+};
 
-in LightSource lS[NUM_OF_LIGHTS];
-in vec3 tanCamPos;
+#include "frameData.glsl"
+
+// Per cluster offset into clusterLights and light count, filled by LightClusters
+layout(std430, binding = 3) readonly buffer ClusterRanges {
+	uvec2 clusterRanges[];
+};
+
+layout(std430, binding = 4) readonly buffer ClusterLights {
+	uint clusterLights[];
+};
+
+uint findCluster()
+{
+	float depth = -(toCamera * vec4(v.thePosition, 1.0f)).z;
+	uint slice = uint(max(log(depth) * clusterDepth.x + clusterDepth.y, 0.0f));
+
+	uvec2 tile = uvec2(gl_FragCoord.xy / viewportSize.xy * vec2(clusterGrid.xy));
+	tile = min(tile, clusterGrid.xy - 1);
+	slice = min(slice, clusterGrid.z - 1);
+
+	return tile.x + clusterGrid.x * (tile.y + clusterGrid.y * slice);
+}
 
 
 // The color of the fragment
@@ -35,9 +57,7 @@ void main(void)
 {
 
 // ========= Light and Material properties ========
-	vec3 lightSource_diffuse = vec3(1.0f, 1.0f, 1.0f);
 	vec3 lightSource_ambient = vec3(1.0f, 1.0f, 1.0f);
-	vec3 lightSource_specular = vec3(1.0f, 1.0f, 1.0f);
 
 	vec3 material_ambient = vec3(0.1f, 0.1f, 0.1f);
 	vec3 material_diffuse = vec3(0.6f, 0.6f, 0.6f);
@@ -59,10 +79,26 @@ void main(void)
 	vec3 result = ambientComp;
 
 
-	// Calculate light for all light sources
-	for(int i = 0; i < NUM_OF_LIGHTS; i++)
+	// Calculate light for the light sources touching this fragment's cluster
+	uvec2 range = clusterRanges[findCluster()];
+
+	for(uint j = 0; j < range.y; j++)
 	{
-  		vec3 lightToFragment = normalize(lS[i].tanPos - v.tangentPos);
+		uint i = clusterLights[range.x + j];
+
+		vec3 lightSource_diffuse = lights[i].diffuse.xyz;
+		vec3 lightSource_specular = lights[i].specular.xyz;
+
+		// Smooth falloff reaching zero at the light's range, so the light can be left out of clusters past it.
+		// A range of 0 means no falloff at all
+		float lightRange = lights[i].position.w;
+		float distanceRatio = lightRange > 0.0f ? distance(v.thePosition, lights[i].position.xyz) / lightRange : 0.0f;
+		float attenuation = clamp(1.0f - distanceRatio * distanceRatio, 0.0f, 1.0f);
+		attenuation *= attenuation;
+
+		// The lighting direction has always used the light with z flipped, kept as it was
+		vec3 lightTanPos = v.TBN * (lights[i].position.xyz * vec3(1.0f, 1.0f, -1.0f));
+  		vec3 lightToFragment = normalize(lightTanPos - v.tangentPos);
 
   		// diffuse color
   		vec3 diffuseComp = material_diffuse * max(dot(normal, lightToFragment), 0.0) * lightSource_diffuse;
@@ -73,7 +109,7 @@ void main(void)
   		float spec = pow(max(dot(normal, halfwayVector), 0.0), material_shininess);
   		vec3 specComp = lightSource_specular * (spec * material_specular);
 
-		result += diffuseComp + specComp;
+		result += (diffuseComp + specComp) * attenuation;
 
 	}
 
@@ -0,0 +1,10 @@
+// Included by every shader reading binding 0, a block has to be declared the same in all stages of a program.
+// Keep insync with FrameUniforms in headers/Core/Renderer.h
+layout(std140, binding = 0) uniform FrameData {
+	mat4 toCamera;
+	mat4 toProjection;
+	vec4 cameraPosition;
+	vec4 clusterDepth; // slice = log(depth) * x + y
+	uvec4 clusterGrid;
+	vec4 viewportSize;
+};
@@ -0,0 +1,61 @@
+#version 450 core
+
+// Analytic ground grid on y = 0. Lines are measured in pixels with screen space derivatives so they keep
+// the same width at any distance, cells smaller than a few pixels fade out instead of aliasing and the
+// whole grid fades with distance from the camera. Writes the plane's depth so the scene hides it
+in vec3 nearPoint;
+in vec3 farPoint;
+
+#include "frameData.glsl"
+
+// World units between minor lines, every tenth line is a major one
+uniform float gridSpacing;
+// Distance from the camera where the grid is gone
+uniform float fadeDistance;
+
+out vec4 FragmentColor;
+
+const float LineWidth = 1.5; // Pixels
+
+// Coverage of lines every spacing units in coord
+float gridCoverage(vec2 coord, float spacing) {
+	vec2 cell = coord / spacing;
+	vec2 cellsPerPixel = fwidth(cell);
+
+	vec2 pixelsToLine = abs(fract(cell - 0.5) - 0.5) / cellsPerPixel;
+	float coverage = 1.0 - min(min(pixelsToLine.x, pixelsToLine.y) / LineWidth, 1.0);
+
+	// Gone by the time cells are 2 pixels across
+	return coverage * (1.0 - smoothstep(0.2, 0.5, max(cellsPerPixel.x, cellsPerPixel.y)));
+}
+
+// Coverage of the line where coord is 0
+float axisCoverage(float coord) {
+	return 1.0 - min(abs(coord) / fwidth(coord) / LineWidth, 1.0);
+}
+
+void main(void)
+{
+	float t = -nearPoint.y / (farPoint.y - nearPoint.y);
+	vec3 worldPosition = nearPoint + t * (farPoint - nearPoint);
+
+	vec4 clipPosition = toProjection * toCamera * vec4(worldPosition, 1.0);
+	gl_FragDepth = 0.5 * clipPosition.z / clipPosition.w + 0.5;
+
+	float minor = gridCoverage(worldPosition.xz, gridSpacing);
+	float major = gridCoverage(worldPosition.xz, gridSpacing * 10.0);
+	float xAxis = axisCoverage(worldPosition.z);
+	float zAxis = axisCoverage(worldPosition.x);
+
+	vec3 color = vec3(0.4);
+	float alpha = max(minor * 0.4, major * 0.8);
+	if (xAxis > 0.0) { color = mix(color, vec3(0.9, 0.2, 0.2), xAxis); alpha = max(alpha, xAxis); }
+	if (zAxis > 0.0) { color = mix(color, vec3(0.2, 0.3, 0.9), zAxis); alpha = max(alpha, zAxis); }
+
+	alpha *= 1.0 - smoothstep(0.0, fadeDistance, length(worldPosition - cameraPosition.xyz));
+
+	// Only after the derivatives, rays looking up or leaving the far plane before the ground miss it
+	if (t <= 0.0 || t >= 1.0 || alpha <= 0.0) discard;
+
+	FragmentColor = vec4(color, alpha);
+}
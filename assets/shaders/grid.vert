@@ -0,0 +1,32 @@
+#version 450 core
+
+// Fullscreen quad for the ground grid, the corners come from the indices like fullScreenShader.vert.
+// Each corner carries the world points it covers on the near and far planes, the fragment shader
+// intersects the ray between them with the y = 0 plane
+vec2 corners[4] = {
+	{-1.0, -1.0},
+	{-1.0,  1.0},
+	{ 1.0,  1.0},
+	{ 1.0, -1.0},
+};
+
+#include "frameData.glsl"
+
+out vec3 nearPoint;
+out vec3 farPoint;
+
+vec3 unproject(vec2 position, float depth, mat4 toWorld) {
+	vec4 point = toWorld * vec4(position, depth, 1.0);
+	return point.xyz / point.w;
+}
+
+void main() {
+	vec2 corner = corners[gl_VertexID];
+	mat4 toWorld = inverse(toProjection * toCamera);
+
+	// Depth is constant over either plane, so the points interpolate linearly across the screen
+	nearPoint = unproject(corner, -1.0, toWorld);
+	farPoint = unproject(corner, 1.0, toWorld);
+
+	gl_Position = vec4(corner, 0.0, 1.0);
+}
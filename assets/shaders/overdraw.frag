@@ -0,0 +1,12 @@
+#version 450 core
+
+// Replaces the main pass shader in the overdraw view, every fragment that would have been shaded
+// adds this with additive blending. Red saturates after about 12 layers, green 25 and blue 50
+layout(early_fragment_tests) in;
+
+out vec4 FragmentColor;
+
+void main(void)
+{
+	FragmentColor = vec4(0.08f, 0.04f, 0.02f, 1.0f);
+}
@@ -0,0 +1,32 @@
+#version 450
+
+// Scales the part of the scene texture the Renderer rendered into up to the full output
+
+layout(binding = 0) uniform sampler2D scene;
+
+out vec4 fragColor;
+in vec2 texture_coords;
+
+// xy: fraction of the scene texture that was rendered, zw: size of one scene texel in uv
+uniform vec4 sourceScale;
+// 0 is plain bilinear, 1 a strong unsharp mask
+uniform float sharpness;
+
+vec3 fetch(vec2 uv) {
+	// Keep the filter footprint inside the rendered area
+	return texture(scene, clamp(uv, 0.5 * sourceScale.zw, sourceScale.xy - 0.5 * sourceScale.zw)).rgb;
+}
+
+void main() {
+	vec2 uv = texture_coords * sourceScale.xy;
+	vec3 color = fetch(uv);
+
+	if (sharpness > 0.0) {
+		vec2 texel = sourceScale.zw;
+		vec3 neighbours = fetch(uv + vec2(texel.x, 0.0)) + fetch(uv - vec2(texel.x, 0.0)) +
+			fetch(uv + vec2(0.0, texel.y)) + fetch(uv - vec2(0.0, texel.y));
+		color = clamp(color + sharpness * (color - 0.25 * neighbours), 0.0, 1.0);
+	}
+
+	fragColor = vec4(color, 1.0);
+}
@@ -1,43 +1,54 @@
 #version 450 core
 
-#define NUM_OF_LIGHTS 1
-
-in vec3 position;
-in vec3 normal;
-in vec2 texCoord;
-in vec3 tangent;
-
-struct LightSource
-{
-	vec3 tanPos;
-};
+// Interleaved PackedVertex, keep insync with headers/Core/VertexFormat.h
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 normalOct;  // octahedral encoded, snorm16
+layout(location = 2) in vec2 texCoord;   // half floats
+layout(location = 4) in uint drawId;     // index into ObjectBuffer
 
 out Vertex {
 	vec3 thePosition;
 	vec2 theTexCoord;
 	vec3 theNormal;
 	vec3 tangentPos;
+	mat3 TBN; // World to tangent space, lights are moved into it per fragment
 } v;
 
-out LightSource lS[NUM_OF_LIGHTS];
 out vec3 tanCamPos;
 
-// Uniforms
-uniform LightSource lightPosition[NUM_OF_LIGHTS];
-uniform vec3 cameraPosition;
+// Has to match the depth pre-pass exactly, see depthPrepass.vert
+invariant gl_Position;
+
+#include "frameData.glsl"
+
+// Keep insync with ObjectUniforms in headers/Core/Renderer.h
+struct ObjectData {
+	mat4 toWorld;
+	mat4 modelMatrix;
+};
+
+layout(std430, binding = 1) readonly buffer ObjectBuffer {
+	ObjectData objects[];
+};
 
-uniform mat4 toCamera = mat4(1);
-uniform mat4 toProjection = mat4(1);
-uniform mat4 toWorld = mat4(1);
-uniform mat4 modelMatrix = mat4(1);
+vec3 octDecode(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+	if (n.z < 0.0f)
+		n.xy = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+	return normalize(n);
+}
 
 void main(void)
 {
-	gl_Position = toProjection * toCamera * toWorld * modelMatrix * vec4(position, 1.0f);
+	vec3 normal = octDecode(normalOct);
+	mat4 toWorld = objects[drawId].toWorld * objects[drawId].modelMatrix;
+
+	gl_Position = toProjection * toCamera * toWorld * vec4(position, 1.0f);
 
-	v.theNormal = normalize(vec3(toWorld * modelMatrix * vec4(normal, 0.0f)));
+	v.theNormal = normalize(vec3(toWorld * vec4(normal, 0.0f)));
 	v.theTexCoord = texCoord;
-	v.thePosition = vec3(toWorld * modelMatrix * vec4(position, 1.0f));
+	v.thePosition = vec3(toWorld * vec4(position, 1.0f));
 
 
 	// For normal mapping
@@ -47,12 +58,7 @@ void main(void)
 
 	mat3 TBN = transpose(mat3(T, B, N));
 
-	tanCamPos         = TBN * cameraPosition;
+	tanCamPos         = TBN * cameraPosition.xyz;
 	v.tangentPos      = vec3(0);// TBN * vec3(toWorld * modelMatrix * vec4(0, 0, 0, 1.0f));
-
-	// Translate light
-	for(int i = 0; i < NUM_OF_LIGHTS; i++)
-        	//lS[i].tanPos = vec3(toProjection * toCamera * toWorld * vec4(lightPosition[i].tanPos, 1.0f)); 
-        	lS[i].tanPos = TBN * lightPosition[i].tanPos;
-	
+	v.TBN             = TBN;
 };  
@@ -27,10 +27,12 @@ namespace NoxEngine {
 		glm::vec3 get_ambient() const override { return ambient; }
 		glm::vec3 get_diffuse() const override { return diffuse; }
 		glm::vec3 get_specular() const override { return specular; }
+		f32 get_range() const override { return range; }
 
 		void set_ambient(glm::vec3 value) override { ambient = value; }
 		void set_diffuse(glm::vec3 value) override { diffuse = value; }
 		void set_specular(glm::vec3 value) override { specular = value; }
+		void set_range(f32 value) override { range = value; }
 
 
 		Entity* getParentEntity() override { return parent; };
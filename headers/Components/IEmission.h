@@ -16,14 +16,19 @@ namespace NoxEngine {
 		glm::vec3 ambient;
 		glm::vec3 diffuse;
 		glm::vec3 specular;
+		// Distance at which the light has faded out, lights are only binned into clusters within it.
+		// 0 means no falloff, the light reaches every cluster and shades as it did before lights had a range
+		f32 range = 0.0f;
 
 
 		virtual glm::vec3 get_ambient() const { return ambient; }
 		virtual glm::vec3 get_diffuse() const { return diffuse; }
 		virtual glm::vec3 get_specular() const { return specular; }
+		virtual f32 get_range() const { return range; }
 
 		virtual void set_ambient(glm::vec3 value) { ambient = value; }
 		virtual void set_diffuse(glm::vec3 value) { diffuse = value; }
 		virtual void set_specular(glm::vec3 value) { specular = value; }
+		virtual void set_range(f32 value) { range = value; }
 	};
 };
\ No newline at end of file
@@ -12,6 +12,16 @@
 #include <glad/glad.h>
 
 namespace NoxEngine {
+
+	// Full detail counts as the first level
+	const u32 kMaxLodLevels = 4;
+
+	// A coarser version of a mesh, indexing the same vertices
+	struct LodLevel {
+		Array<i32> indices;
+		f32 error; // How far the surface may have moved from the full mesh, in mesh units
+	};
+
 	class IRenderable
 	{
 
@@ -29,6 +39,8 @@ namespace NoxEngine {
 			virtual const Array<vec3>& getNormals  () const = 0;
 			virtual const Array<ivec3>& getFaces   () const = 0;
 			virtual const Array<i32>& getIndices   () const = 0;
+			// Coarsest last, empty for renderables drawn at full detail only
+			virtual const Array<LodLevel>& getLods () const { return lods; }
 
 			virtual const String getNormalTexture() = 0;
 			virtual const String getAmbientTexture() = 0;
@@ -39,6 +51,7 @@ namespace NoxEngine {
 			Array<vec3>    normals;
 			Array<ivec3>     faces;
 			Array<i32>     indices;
+			Array<LodLevel>   lods;
 
 			i8 has_texture;
 			i8 has_normal;
@@ -48,8 +61,12 @@ namespace NoxEngine {
 			GLenum glRenderType;
 			f32 lineWidth = 1.0;
 
-			// id of this IRenderable in the renderer
-			u32 rendObjId;
+			// handle of this IRenderable in the renderer, -1 until it is added
+			u32 rendObjId = -1;
+
+			// Renderables with the same non-empty key share one copy of the geometry on the GPU,
+			// e.g. "assets/meshes/card.fbx#0" for the first mesh of card.fbx
+			String geometryKey;
 	
 	};
 }
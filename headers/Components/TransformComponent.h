@@ -6,6 +6,8 @@
 
 /*
 * Position Component. Handles postion of the the entity in the 3D world
+* Keeps the world matrix (translation * euler XYZ rotation * scale) cached, the setters mark it dirty and
+* updateWorldMatrices rebuilds the dirty ones once a frame. Code writing x..sz directly must call markDirty().
 */
 
 namespace NoxEngine {
@@ -26,25 +28,49 @@ namespace NoxEngine {
 			f32 get_y() const override { return y; }
 			f32 get_z() const override { return z; }
 
-			void set_x(f32 value) override { x = value; }
-			void set_y(f32 value) override { y = value; }
-			void set_z(f32 value) override { z = value; }
+			void set_x(f32 value) override { x = value; markDirty(); }
+			void set_y(f32 value) override { y = value; markDirty(); }
+			void set_z(f32 value) override { z = value; markDirty(); }
 
 			f32 get_rx() const override { return rx; }
 			f32 get_ry() const override { return ry; }
 			f32 get_rz() const override { return rz; }
 
-			void set_rx(f32 value) override { rx = value; }
-			void set_ry(f32 value) override { ry = value; }
-			void set_rz(f32 value) override { rz = value; }
+			void set_rx(f32 value) override { rx = value; markDirty(); }
+			void set_ry(f32 value) override { ry = value; markDirty(); }
+			void set_rz(f32 value) override { rz = value; markDirty(); }
 
 			f32 get_sx() const override { return sx; }
 			f32 get_sy() const override { return sy; }
 			f32 get_sz() const override { return sz; }
 
-			void set_sx(f32 value) override { sx = value; }
-			void set_sy(f32 value) override { sy = value; }
-			void set_sz(f32 value) override { sz = value; }
+			void set_sx(f32 value) override { sx = value; markDirty(); }
+			void set_sy(f32 value) override { sy = value; markDirty(); }
+			void set_sz(f32 value) override { sz = value; markDirty(); }
+
+			inline void markDirty() { dirty = true; }
+			inline bool isDirty() const { return dirty; }
+
+			// Rebuilt on the spot if a field changed since the last update
+			const mat4& getWorldMatrix();
+
+			// Changes every time the world matrix is rebuilt, unique across all transforms
+			inline u32 getVersion() const { return version; }
+
+			// Rotated axes without the scale, for audio orientation
+			vec3 getForward();
+			vec3 getUp();
+
+			// Rebuilds the world matrix of every dirty transform in the list, clean ones are skipped
+			static void updateWorldMatrices(const Array<TransformComponent*> &transforms);
+
+		private:
+			void updateWorldMatrix();
+			void writeWorldMatrix(f32 s1, f32 s2, f32 s3, f32 c1, f32 c2, f32 c3);
+
+			mat4 worldMatrix;
+			u32 version;
+			bool dirty;
 	};
 }
 
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Core/Types.h>
+
+namespace NoxEngine {
+
+	struct AABB {
+		vec3 min;
+		vec3 max;
+
+		// Box of the 8 transformed corners, computed from center/extents
+		AABB transformed(const mat4 &m) const;
+		AABB merged(const AABB &other) const;
+		AABB expanded(f32 margin) const;
+		bool contains(const AABB &other) const;
+		f32 surfaceArea() const;
+	};
+
+	AABB computeAABB(const Array<vec3> &points);
+
+	/*
+	 * Six planes (left, right, bottom, top, near, far) pointing inwards,
+	 * extracted from a view-projection matrix.
+	 * */
+	struct Frustum {
+		enum Result { Outside, Intersects, Inside };
+
+		vec4 planes[6];
+
+		Frustum() = default;
+		Frustum(const mat4 &viewProjection);
+
+		Result test(const AABB &box) const;
+	};
+
+	/*
+	 * Dynamic AABB tree. Leaves hold a box enlarged by a margin so small movements don't touch the tree,
+	 * inserting picks the sibling with the lowest surface area cost and the tree is kept balanced with rotations.
+	 * */
+	class AABBTree {
+		public:
+			static const i32 NullNode = -1;
+
+			AABBTree(f32 margin = 0.5f);
+
+			i32 createProxy(const AABB &box, u32 userData);
+			void destroyProxy(i32 proxy);
+			// Returns true if the proxy had to be reinserted
+			bool moveProxy(i32 proxy, const AABB &box);
+			void clear();
+
+			// Appends the userData of every leaf inside or touching the frustum to result
+			void query(const Frustum &frustum, Array<u32> &result) const;
+
+			inline u32 getProxyCount() const { return _proxyCount; }
+			i32 getHeight() const;
+
+		private:
+			struct Node {
+				AABB box;
+				i32 parent; // Next free node when the node is in the free list
+				i32 left;
+				i32 right;
+				i32 height; // Leaf = 0, free = -1
+				u32 userData;
+
+				inline bool isLeaf() const { return left == NullNode; }
+			};
+
+			i32 allocateNode();
+			void freeNode(i32 node);
+			void insertLeaf(i32 leaf);
+			void removeLeaf(i32 leaf);
+			i32 balance(i32 node);
+			void collectLeaves(i32 node, Array<u32> &result) const;
+
+			Array<Node> _nodes;
+			mutable Array<i32> _stack; // Scratch for query, kept to avoid reallocating every frame
+			i32 _root;
+			i32 _freeList;
+			u32 _proxyCount;
+			f32 _margin;
+	};
+}
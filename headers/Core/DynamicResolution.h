@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Core/Types.h>
+
+namespace NoxEngine {
+
+	struct DynamicResolutionSettings {
+		f32 minScale = 0.5f;
+		f32 maxScale = 1.0f; // Targets are allocated at the output size, so never above 1
+		f64 targetMs = 14.0; // Leaves room under 16.6 for the GUI and the swap
+		f64 headroom = 0.1; // Fraction of targetMs the frame time has to be off by before anything changes
+		u32 sampleFrames = 30; // Frame times averaged per decision
+		u32 cooldownFrames = 30; // Frames to wait after a change, GPU timings lag a few frames
+		f32 step = 0.05f; // Scales are multiples of this so the render size doesn't creep by a pixel a frame
+	};
+
+	/*
+	 * Picks the fraction of the output resolution the scene renders at from measured frame times.
+	 * Pixel cost goes with the square of the scale, so a slow frame drops straight to the scale that
+	 * should fit targetMs. Going back up is one step at a time and only if the predicted time at the
+	 * larger scale still has headroom left, the gap between the two thresholds keeps it from oscillating.
+	 * */
+	class DynamicResolution {
+		public:
+			DynamicResolution();
+
+			// Feeds the time of one frame, returns the scale for the next one
+			f32 update(f64 frameMs);
+
+			void setEnabled(bool enabled);
+			inline bool isEnabled() const { return _enabled; }
+
+			inline void setSettings(const DynamicResolutionSettings &settings) { _settings = settings; }
+			inline const DynamicResolutionSettings& getSettings() const { return _settings; }
+
+			inline f32 getScale() const { return _scale; }
+			inline f64 getAverageMs() const { return _averageMs; }
+
+		private:
+			f32 quantize(f32 scale) const;
+
+			DynamicResolutionSettings _settings;
+			bool _enabled;
+			f32 _scale;
+			f64 _sampleSum;
+			u32 _sampleCount;
+			u32 _framesSinceChange;
+			f64 _averageMs;
+	};
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Utils/ThreadPool.h>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+namespace NoxEngine {
+
+	// World transform of one renderer object as the simulation left it
+	struct PacketTransform {
+		u32 handle; // Into the Renderer's objects, may be gone by the time the packet is drawn
+		u32 version; // TransformComponent::getVersion(), 0 without a transform
+		mat4 worldTransform;
+	};
+
+	struct PacketAnimation {
+		u32 handle;
+		mat4 transformation;
+	};
+
+	// Everything the Renderer reads from the entities, copied out so the next frame can be simulated while it draws
+	struct RenderPacket {
+		u64 frame;
+		Array<PacketTransform> transforms;
+		Array<PacketAnimation> animations;
+
+		// Indexed like the Renderer's lights if lightSetVersion still matches, w is 0 for lights without a transform
+		u32 lightSetVersion;
+		Array<vec4> lightPositions;
+	};
+
+	struct FramePacingStats {
+		f64 simulationMs; // Time the simulation thread spent filling a packet
+		f64 renderMs; // Main thread time from publishing a packet to the buffer swap
+		f64 overlapMs; // Part of simulationMs that ran while the main thread was rendering
+		f64 waitMs; // Main thread blocked on the simulation at the start of the frame
+	};
+
+	/*
+	 * Runs the simulation of frame N+1 on its own thread while the main thread draws frame N.
+	 * Two RenderPackets take turns: the simulation fills the back one, launchSimulation() publishes it as the front
+	 * one and starts filling the other. Between waitForSimulation() and launchSimulation() the main thread owns the
+	 * game state, after the launch it may only read the published packet and whatever the simulation doesn't write.
+	 * With pipelining off the simulation runs inline at the launch, like a plain serial frame. The first frame is
+	 * simulated inline too, the simulation only starts running ahead from the launch after it, which draws the
+	 * inline packet a second time.
+	 * */
+	class FramePipeline {
+		public:
+			typedef std::function<void(RenderPacket&)> SimulationJob;
+
+			FramePipeline();
+			~FramePipeline();
+
+			// Blocks until the simulation started by the last launch has finished
+			void waitForSimulation();
+
+			// Publishes the last simulated packet and starts the next simulation. The returned packet stays
+			// untouched until the next launch
+			const RenderPacket& launchSimulation(const SimulationJob &job);
+
+			// Call after the buffer swap, ends the render span the overlap is measured against
+			void endFrame();
+
+			inline void setPipelined(bool enabled) { _pipelined = enabled; }
+			inline bool isPipelined() const { return _pipelined; }
+			inline const FramePacingStats& getStats() const { return _stats; }
+
+		private:
+			typedef std::chrono::high_resolution_clock Clock;
+
+			void blockUntilIdle();
+			void simulate(const SimulationJob &job, RenderPacket &packet);
+			void updateStats();
+
+			std::mutex _mutex;
+			std::condition_variable _finished;
+			bool _running;
+
+			RenderPacket _packets[2];
+			u32 _front;
+			bool _backReady; // The back packet holds a finished simulation that wasn't published yet
+			bool _frontInline; // The front packet was simulated inline at the last launch, nothing runs ahead of it
+			bool _pipelined;
+			u64 _frame;
+
+			// Written by the simulation thread, read once waitForSimulation() returned
+			Clock::time_point _simulationStart;
+			Clock::time_point _simulationEnd;
+			Clock::time_point _renderStart;
+			Clock::time_point _renderEnd;
+			FramePacingStats _stats;
+
+			// Last so its thread is joined before anything the job uses goes away
+			ThreadPool _worker;
+	};
+}
@@ -1,6 +1,8 @@
 /*
 * A class encapsulating shaders.
 * Stores, compiles and links vertex and fragment shaders given the paths to the shader files
+* Programs are restored from the ProgramBinaryCache when possible. With KHR_parallel_shader_compile the
+* constructor only starts compiling, finishLink() waits for the result and is called on first use.
 */
 
 #pragma once
@@ -22,18 +24,28 @@ namespace NoxEngine {
 		protected:
 			u32 compileShader(String& filename, i32 shaderType);
 			GLuint compileShaderFromString(std::string shaderData, GLenum shaderType);
-			u32 makeProgram(Array<ShaderFile> shaders);
 			u32 _id;
 
+			bool _pending; // Compile and link issued, result not checked yet
+			u64 _binaryKey; // ProgramBinaryCache key of the sources the program was built from
+
 			Array<ShaderFile> _shaders; // Need to hold onto the info on shaders to change them on the go
 
-		public:
-			u32 numOfLights = 0;
+			// Uniform name -> location, filled on first use. Must be cleared whenever _id is relinked
+			mutable Map<String, i32> _uniformLocations;
+			i32 getCachedUniformLocation(const String& name) const;
+			inline void invalidateUniformLocations() { _uniformLocations.clear(); }
 
+		public:
 			GLProgram(Array<ShaderFile> shaders);
 			void use();
 
-			inline u32 getProgramId() { return _id; };
+			// Waits for the driver, logs errors and stores the binary. Does nothing once done
+			void finishLink();
+			// Never blocks, true once finishLink() wouldn't have to wait
+			bool isReady() const;
+
+			inline u32 getProgramId() { finishLink(); return _id; };
 
 			void setBool(const String& name, bool value) const;
 			void setInt(const String& name, i32 value) const;
@@ -48,8 +60,5 @@ namespace NoxEngine {
 			int getAtrributeLocation(const String& name);
 			void printAttribInfo();
 
-			// The change of the num of the light sources requires 
-			void changeLightNum(i32 num_of_light);
-
 	};
 }
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Managers/Singleton.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	struct GLStateStats {
+		u32 bindsIssued;
+		u32 bindsSkipped;
+	};
+
+	/*
+	 * Shadow copy of the bindings the renderer changes most, a bind to what is already bound is skipped.
+	 * Textures are bound with glBindTextureUnit so the active texture unit is never touched.
+	 * Code that binds with raw GL calls has to invalidate() afterwards, the cache assumes it is the only writer.
+	 * */
+	class GLStateCache : public Singleton<GLStateCache> {
+		friend class Singleton<GLStateCache>;
+
+		public:
+			static const u32 MaxTextureUnits = 16;
+
+			void useProgram(GLuint program);
+			void bindFramebuffer(GLuint framebuffer);
+			void bindVertexArray(GLuint vertexArray);
+			void bindTexture(u32 unit, GLuint texture);
+
+			inline GLuint getProgram() const { return _program; }
+
+			// Forget everything, the next bind of each kind always reaches GL
+			void invalidate();
+
+			// Call once at the start of a frame, GL state is unknown after the GUI has drawn
+			void beginFrame();
+
+			inline const GLStateStats& getStats() const { return _lastFrame; }
+			// Counts so far in the frame that is still running
+			inline const GLStateStats& getCurrentStats() const { return _frame; }
+
+		private:
+			GLStateCache();
+
+			// Returns true if the bind has to be issued
+			bool track(GLuint &current, GLuint value);
+
+			GLuint _program;
+			GLuint _framebuffer;
+			GLuint _vertexArray;
+			GLuint _textures[MaxTextureUnits];
+
+			GLStateStats _frame;
+			GLStateStats _lastFrame;
+	};
+}
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "Renderer.h"
+#include "FramePipeline.h"
 #include "Types.h"
 #include "MeshScene.h"
 #include "Scene.h"
 
 #include <FullscreenShader.h>
+#include <PostProcessChain.h>
 
 namespace NoxEngine {
 
@@ -25,6 +27,7 @@ namespace NoxEngine {
 	struct GameState {
 		FullscreenShader *current_post_processor;
 		Renderer *renderer;
+		FramePipeline *framePipeline;
 		Scene *activeScene;
 		Entity* activeAudioListener;	// Entity is needed because IAudioListener and ITransform are both needed
 		Array<Scene *> scenes;
@@ -34,10 +37,12 @@ namespace NoxEngine {
 		Array<String> selectedAudio;
 
 		Array<FullscreenShader> post_processors;
+		PostProcessChain post_process_chain;
 		Array<Camera*> cameras;
 
 		// u32 texture_used;
 		u32 fullscreen_shader_texture_used;
+		i32 fullscreen_shader_pass_used; // Index into post_processors, -1 shows the Renderer's output
 		Array<vec3> lightSources;
 		u32 prev_win_height;
 		u32 prev_win_width;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	// A sub-range of a pool, offset and count are in pool elements (vertices or indices), not bytes
+	struct PoolRange {
+		u32 offset;
+		u32 count;
+	};
+
+	/*
+	 * First-fit free list over [0, capacity).
+	 * Free ranges are kept sorted by offset so neighbours can be merged on release.
+	 * */
+	class RangeAllocator {
+		public:
+			RangeAllocator(u32 capacity = 0);
+
+			// Returns false if no free range is big enough, the caller should grow and retry
+			bool allocate(u32 count, PoolRange &range);
+			void release(PoolRange range);
+			void grow(u32 newCapacity);
+			void reset();
+
+			inline u32 getCapacity() const { return _capacity; }
+			inline u32 getUsed() const { return _used; }
+			u32 getLargestFree() const;
+
+		private:
+			Array<PoolRange> _free;
+			u32 _capacity;
+			u32 _used;
+	};
+
+	/*
+	 * A set of GL buffers that share one RangeAllocator, one buffer per stride.
+	 * Data for a range is written with glNamedBufferSubData so only the touched range goes to the GPU.
+	 * When the pool runs out of space every buffer is reallocated with double the capacity
+	 * and the old content is copied over on the GPU.
+	 * */
+	class GeometryPool {
+		public:
+			GeometryPool(u32 initialCapacity, const Array<u32> &strides);
+			~GeometryPool();
+
+			// Returns true if the buffers were reallocated, the caller then has to rebind them
+			bool allocate(u32 count, PoolRange &range);
+			void release(PoolRange range);
+			void reset();
+
+			void upload(u32 bufferIndex, PoolRange range, const void *data);
+
+			inline GLuint getBuffer(u32 bufferIndex) const { return _buffers[bufferIndex]; }
+			inline u32 getCapacity() const { return _ranges.getCapacity(); }
+			inline u32 getUsed() const { return _ranges.getUsed(); }
+
+		private:
+			void grow(u32 minCapacity);
+
+			RangeAllocator _ranges;
+			Array<u32> _strides;
+			Array<GLuint> _buffers;
+	};
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Managers/Singleton.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	// GPU time of one named scope, averaged over the last HistorySize frames it ran in
+	struct GpuTimer {
+		static const u32 HistorySize = 120;
+
+		String name;
+		u32 depth; // Nesting level of the scope, 0 for top level scopes
+		f64 lastMs;
+		f64 averageMs;
+		f64 minMs;
+		f64 maxMs;
+		f64 history[HistorySize];
+		u32 historyCount;
+		u32 historyNext;
+	};
+
+	/*
+	 * Times GPU work between begin() and end() with GL_TIMESTAMP queries.
+	 * Each frame writes its queries into its own slot of a ring FrameLatency frames deep, a slot is read back
+	 * when it comes round again, by then the GPU has long finished it and reading never stalls. If it hasn't,
+	 * that frame's results are dropped instead of waited for.
+	 * Scopes nest, a timer is identified by its name and nesting level.
+	 * */
+	class GpuProfiler : public Singleton<GpuProfiler> {
+		friend class Singleton<GpuProfiler>;
+
+		public:
+			static const u32 FrameLatency = 4;
+
+			// Call once per frame before the first scope, collects the results of the slot about to be reused
+			void beginFrame();
+
+			void begin(const char *name);
+			void end();
+
+			inline void setEnabled(bool enabled) { _enabled = enabled; }
+			inline bool isEnabled() const { return _enabled; }
+
+			inline const Array<GpuTimer>& getTimers() const { return _timers; }
+			inline u32 getDroppedFrames() const { return _droppedFrames; }
+			// Sum of the top level scopes of the latest frame read back, FrameLatency frames old
+			inline f64 getFrameMs() const { return _frameMs; }
+
+			// One line per timer with its last, average, min and max milliseconds
+			bool writeCsv(const String &path) const;
+
+		private:
+			GpuProfiler();
+
+			struct Scope {
+				u32 timer;
+				GLuint startQuery;
+				GLuint endQuery;
+			};
+
+			struct FrameQueries {
+				Array<Scope> scopes;
+				Array<GLuint> queries; // Created as the frame first needs them, reused every lap of the ring
+				u32 queriesUsed;
+			};
+
+			GLuint nextQuery();
+			u32 findTimer(const char *name, u32 depth);
+			void collect(FrameQueries &frame);
+
+			FrameQueries _frames[FrameLatency];
+			u32 _frame;
+			Array<u32> _openScopes; // Into the current frame's scopes, innermost last
+			Array<GpuTimer> _timers;
+			u32 _droppedFrames;
+			f64 _frameMs;
+			bool _enabled;
+	};
+
+	// Times the enclosing block
+	class GpuProfileScope {
+		public:
+			inline GpuProfileScope(const char *name) { GpuProfiler::Instance()->begin(name); }
+			inline ~GpuProfileScope() { GpuProfiler::Instance()->end(); }
+	};
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Core/GLProgram.h>
+#include <Core/AABBTree.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	/*
+	 * Occlusion test against a max depth pyramid of an earlier frame.
+	 * build() reduces the scene depth on the GPU with a compute shader, 2x2 texels into one, down to a level
+	 * no wider than ReadbackWidth. That level is copied into a pixel buffer and read on the CPU once its fence
+	 * has passed, usually a frame or two later, so reading never stalls. The CPU builds the remaining levels.
+	 * Boxes are projected with the view-projection the depth was drawn with and tested against the level where
+	 * their screen rectangle covers at most 2x2 texels: a box whose nearest point is behind the farthest depth
+	 * there is hidden. Something that just came out from behind an occluder shows up as soon as a newer
+	 * pyramid arrives.
+	 * */
+	class HiZBuffer {
+		public:
+			static const u32 ReadbackWidth = 160;
+			static const u32 ReadbackSlots = 3;
+
+			HiZBuffer();
+			~HiZBuffer();
+
+			// Reduces the width x height corner of depthTexture, drawn with viewProjection, and starts reading it back
+			void build(GLuint depthTexture, u32 width, u32 height, const mat4 &viewProjection);
+			// Picks up the newest finished read back, call once per frame before testing
+			void collect();
+			// Drops the pyramid, nothing is occluded until the next one arrives
+			void clear();
+
+			// False whenever it can't tell, boxes crossing the near plane or off the pyramid's screen are visible
+			bool isOccluded(const AABB &bounds) const;
+
+		private:
+			struct Level {
+				u32 width;
+				u32 height;
+				Array<f32> depths;
+			};
+
+			struct Readback {
+				GLuint buffer;
+				GLsync fence; // nullptr when the slot is free
+				u32 width;
+				u32 height;
+				u32 shift; // Level texels cover 1 << shift pixels
+				u32 screenWidth; // Size of the depth it was reduced from
+				u32 screenHeight;
+				mat4 viewProjection;
+			};
+
+			void allocate(u32 width, u32 height);
+
+			GLProgram *_downsample;
+			GLuint _pyramid;
+			u32 _pyramidWidth; // Size of the depth it was allocated for
+			u32 _pyramidHeight;
+			u32 _pyramidLevels;
+
+			Readback _readbacks[ReadbackSlots];
+			u32 _nextReadback;
+
+			// Pyramid of the newest read back, finest first
+			Array<Level> _levels;
+			u32 _firstShift;
+			u32 _screenWidth;
+			u32 _screenHeight;
+			mat4 _viewProjection;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Core/StreamBuffer.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	// std430 per light entry, position.w is the range past which the light has no effect, 0 for no falloff
+	struct LightUniforms {
+		vec4 position;
+		vec4 diffuse;
+		vec4 specular;
+	};
+
+	/*
+	 * Froxel grid for clustered forward lighting.
+	 * The view frustum is split into GridX * GridY screen tiles and GridZ exponential depth slices,
+	 * every light's sphere is binned into the clusters it overlaps on the CPU each frame.
+	 * The fragment shader finds its cluster and only loops over the lights listed for it.
+	 * The cluster lists are rewritten every frame, they go into the StreamBuffer.
+	 * */
+	class LightClusters {
+		public:
+			static const u32 GridX = 16;
+			static const u32 GridY = 9;
+			static const u32 GridZ = 24;
+			static const u32 ClusterCount = GridX * GridY * GridZ;
+
+			LightClusters();
+			~LightClusters();
+
+			void build(const Array<LightUniforms> &lights, const mat4 &view, const mat4 &projection);
+			void bind(u32 rangeBinding, u32 indexBinding);
+
+			// Slice of a view depth is floor(log(depth) * x + y), z and w are the near and far planes
+			inline const vec4& getDepthParams() const { return _depthParams; }
+
+			inline f64 getBinningMs() const { return _binningMs; }
+			inline u32 getIndexCount() const { return (u32)_indices.size(); }
+
+		private:
+			// Light bounds in clusters, one array per field so the bounds loop vectorises
+			Array<f32> _viewX, _viewY, _viewZ, _radius;
+			Array<i32> _minX, _maxX, _minY, _maxY, _minZ, _maxZ;
+
+			// Per cluster offset into _indices and light count, matches uvec2 in the shader
+			Array<u32> _ranges;
+			Array<u32> _indices;
+
+			// This frame's copies in the StreamBuffer
+			StreamRange _rangeSlice;
+			StreamRange _indexSlice;
+
+			vec4 _depthParams;
+			f64 _binningMs;
+	};
+}
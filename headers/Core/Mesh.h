@@ -1,6 +1,7 @@
 #pragma once
 #include <Components/RenderableComponent.h>
 #include <Core/Types.h>
+#include <Core/VertexCacheOptimizer.h>
 #include <Utils/Utils.h>
 
 namespace NoxEngine {
@@ -9,6 +10,8 @@ namespace NoxEngine {
 	public:
 		Mesh();
 		Mesh(const Mesh& other);
+		// Shares the geometry arrays of source instead of copying them, source has to outlive this mesh
+		Mesh(const Mesh* source);
 		Mesh(std::istream& stream);
 		~Mesh();
 
@@ -16,6 +19,27 @@ namespace NoxEngine {
 		String name;
 		bool hasBones;
 
+		// Mesh owning the geometry arrays, nullptr if this mesh owns its own
+		const Mesh* geometrySource;
+
+		inline const i32 getNumOfVertices() const override { return (i32)getVertices().size(); }
+		inline const i32 getNumOfTexCoord() const override { return (i32)getTexCoords().size(); }
+		inline const i32 getNumOfNormals()  const override { return (i32)getNormals().size(); }
+		inline const i32 getNumOfFaces()	const override { return (i32)getFaces().size(); }
+
+		const Array<vec3>&  getVertices () const override { return geometrySource ? geometrySource->getVertices()  : vertices; }
+		const Array<vec2>&  getTexCoords() const override { return geometrySource ? geometrySource->getTexCoords() : texCoords; }
+		const Array<vec3>&  getNormals  () const override { return geometrySource ? geometrySource->getNormals()   : normals; }
+		const Array<ivec3>& getFaces    () const override { return geometrySource ? geometrySource->getFaces()     : faces; }
+		const Array<i32>&   getIndices  () const override { return geometrySource ? geometrySource->getIndices()   : indices; }
+		const Array<LodLevel>& getLods  () const override { return geometrySource ? geometrySource->getLods()      : lods; }
+
+		// Reorders the triangles for the vertex cache and the vertices in the order they are used, at import
+		VertexCacheStats optimizeIndexOrder();
+
+		// Simplified index lists for distance LODs, done once the geometry is loaded
+		void buildLods();
+
 		void setTexture(const String filename);
 
 		const String getNormalTexture() { return normalTexture; }
@@ -23,5 +47,10 @@ namespace NoxEngine {
 		
 		void serialize(std::ostream& stream);
 		void deserialize(std::istream& stream);
+
+	private:
+		// Faces or indices as one flat index list
+		Array<i32> triangleList() const;
+		void setTriangleList(const Array<i32> &triangles);
 	};
 }
@@ -25,6 +25,9 @@ namespace NoxEngine {
 		void updateCeilAndFloor();
 
 		void flipUV();
+
+		// Tag every mesh with "<file>#<mesh index>" so instances of this scene share their geometry
+		void setGeometryKeys(const String& sourceFile);
 		void setAnimationIndex(u32 num);
 
 		// Reset the play time
@@ -64,6 +67,9 @@ namespace NoxEngine {
 
 		bool playAnimation = false;
 
+		// Of all meshes together at import, ACMR weighted by triangles
+		VertexCacheStats vertexCacheStats = {};
+
 		void serialize(std::ostream& stream);
 
 	private:
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Components/IRenderable.h>
+
+namespace NoxEngine {
+
+	/*
+	 * Quadric error edge collapse over an index list. Vertices never move: a collapse points every reference
+	 * of one vertex at a neighbour, so the simplified index lists share the original vertex data.
+	 * Every vertex carries the summed squared distances to the planes of its triangles in the input, the
+	 * cheapest collapses go first, in passes where a vertex and its triangles take part in one collapse at most.
+	 * Collapses that would flip a triangle are skipped. Vertices on an open edge are never collapsed, that keeps
+	 * mesh borders and texture seams, whose vertices are split, from tearing open.
+	 *
+	 * Stops once at most targetIndexCount indices are left or the next collapse would move the surface further
+	 * than maxError. Returns the largest error of the collapses made, in the units of the positions.
+	 * */
+	f32 simplifyMesh(const Array<vec3> &positions, const Array<i32> &indices, u32 targetIndexCount, f32 maxError, Array<i32> &result);
+
+	// Largest error generateLods lets a level of the mesh have, a fraction of its bounds diagonal
+	f32 lodErrorBound(const Array<vec3> &positions);
+
+	// Up to kMaxLodLevels - 1 coarser versions of indices, each with about half the triangles of the one before.
+	// Stops early once a level doesn't get noticeably smaller or would move the surface too far
+	void generateLods(const Array<vec3> &positions, const Array<i32> &indices, Array<LodLevel> &lods);
+}
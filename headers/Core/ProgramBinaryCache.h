@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Managers/Singleton.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	/*
+	 * Linked program binaries kept on disk so the next launch skips compiling.
+	 * Entries are keyed by a hash of the shader sources and types plus the GL vendor, renderer and version,
+	 * a driver update gives new keys instead of binaries the driver would reject. A binary that fails to
+	 * load is removed and the caller compiles from source.
+	 * Also turns on KHR_parallel_shader_compile when the driver has it.
+	 * */
+	class ProgramBinaryCache : public Singleton<ProgramBinaryCache> {
+		friend class Singleton<ProgramBinaryCache>;
+
+		public:
+			u64 makeKey(const Array<String> &sources, const Array<u32> &shaderTypes) const;
+
+			// Links program from the cached binary, false if there is none or the driver refused it
+			bool load(u64 key, GLuint program);
+			void store(u64 key, GLuint program);
+
+			inline bool isEnabled() const { return _enabled; }
+			inline bool hasParallelCompile() const { return _parallelCompile; }
+
+		private:
+			ProgramBinaryCache();
+
+			String pathFor(u64 key) const;
+
+			String _directory;
+			String _driver;
+			bool _enabled;
+			bool _parallelCompile;
+	};
+}
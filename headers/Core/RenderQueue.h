@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Core/Types.h>
+
+namespace NoxEngine {
+
+	struct RenderItem {
+		u64 key;
+		u32 index; // Into whatever list the caller keeps the draws in
+	};
+
+	/*
+	 * Draw items ordered by a 64 bit key, most significant bits first:
+	 *   program 4 | render type 3 | index type 1 | ambient texture 12 | normal texture 12 | geometry 18 | depth 14
+	 * Items sharing state end up together so state changes only happen between runs, same geometry is next to
+	 * each other for instancing and within that the nearest is drawn first. Fields are truncated to their width,
+	 * a collision only costs an extra state change, the draw itself still uses the real state.
+	 * Depth keys put a coarse depth bucket above the state instead, for orders where early depth rejection
+	 * matters more than state changes:
+	 *   depth bucket 8 | render type 3 | index type 1 | ambient texture 12 | normal texture 12 | geometry 18 | depth 10
+	 * The Renderer fills geometry with the vertex range offset in the upper 16 bits and the LOD level in the
+	 * lower 2, so different levels of one mesh never share a key with each other or with another mesh.
+	 * */
+	class RenderQueue {
+		public:
+			static u64 makeKey(u32 program, u32 renderType, u32 indexType, u32 ambientTexture, u32 normalTexture, u32 geometry, f32 depth);
+			static u64 makeDepthKey(u32 renderType, u32 indexType, u32 ambientTexture, u32 normalTexture, u32 geometry, f32 depth);
+
+			inline void clear() { _items.clear(); }
+			inline void push(u64 key, u32 index) { _items.push_back({ key, index }); }
+
+			// Stable LSD radix sort, passes over bytes that are the same for every key are skipped
+			void sort();
+
+			inline const Array<RenderItem>& getItems() const { return _items; }
+
+		private:
+			Array<RenderItem> _items;
+			Array<RenderItem> _scratch;
+	};
+}
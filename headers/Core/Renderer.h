@@ -15,6 +15,20 @@
 #include <Core/Camera.h>
 #include <Core/GLProgram.h>
 #include <Core/Entity.h>
+#include <Core/GeometryPool.h>
+#include <Core/VertexFormat.h>
+#include <Core/AABBTree.h>
+#include <Components/TransformComponent.h>
+#include <Utils/SlotMap.h>
+#include <Core/TextureCache.h>
+#include <Core/LightClusters.h>
+#include <Core/GLStateCache.h>
+#include <Core/RenderQueue.h>
+#include <Core/FramePipeline.h>
+#include <Core/DynamicResolution.h>
+#include <Core/HiZBuffer.h>
+#include <Core/StreamBuffer.h>
+#include <FullscreenShader.h>
 
 #include <Managers/Singleton.h>
 
@@ -25,6 +39,18 @@
 
 
 namespace NoxEngine {
+	// The Renderer's perspective, the benchmarks use it too so their frustums match the editor's
+	const f32 kFieldOfView = 45.0f; // Vertical, in degrees
+	const f32 kNearPlane = 0.1f;
+	const f32 kFarPlane = 10000.0f;
+
+	// One level of detail of an object, the levels share the object's vertices
+	struct LodRange {
+		u32 elementOffset; // In bytes, inside the object's elementRange
+		i32 indexCount;
+		f32 error; // In mesh units, see LodLevel
+	};
+
 	// The objects to render
 	struct RendObj
 	{
@@ -33,13 +59,25 @@ namespace NoxEngine {
 		u32 renderType;
 		i32 has_texture;
 		i32 has_normal;
-		i32 startInd;
-		i32 endInd; // Start and end indixes in the a united element array 
+		u32 indexType; // GL_UNSIGNED_SHORT when the vertices fit, GL_UNSIGNED_INT otherwise
+		i32 indexCount;
+		PoolRange vertexRange; // In vertices, used as the base vertex
+		PoolRange elementRange; // In bytes, indices are relative to the object's first vertex
+		String geometryKey; // Non-empty if the ranges are shared with other objects, see IRenderable::geometryKey
+		u32 lodCount; // Levels in lods, full detail first, indexCount is the first one's
+		LodRange lods[kMaxLodLevels];
+		u32 lod; // Level drawn this frame, picked with the culling
 		u32 normalTexture;
-		u32 ambientTexture; // Texture handlers
+		u32 ambientTexture; // Texture handlers, owned by the Renderer's TextureCache
 		//mat4 pos;
 		mat4 transformation;
 
+		AABB localBounds; // Bounds of the mesh vertices, before any transform
+		mat4 worldTransform; // Cached matrix of the transform component, identity without one
+		mat4 boundsTransform; // worldTransform * transformation the cull proxy was last fitted with
+		u32 transformVersion; // TransformComponent::getVersion() the above were taken at, 0 without a transform
+		i32 cullProxy; // Leaf in the Renderer's cull tree, AABBTree::NullNode for perm objects
+
 		String ambientTexturePath;
 		String normalTexturePath;
 
@@ -47,6 +85,89 @@ namespace NoxEngine {
 		ComponentType componentType;
 	};
 	
+	// Geometry footprint of the renderer, the legacy numbers are what the
+	// separate float arrays and 32 bit indices would have taken for the same data
+	struct GeometryStats {
+		u64 vertices;
+		u64 indices;
+		u64 residentBytes;
+		u64 legacyResidentBytes;
+		u64 lodBytes; // Part of residentBytes taken by coarser LOD index levels, which the old layout didn't have
+		u64 frameBytes; // Vertex and index bytes referenced by the draws of the last frame
+		u64 legacyFrameBytes;
+	};
+
+	// Shader storage/uniform block binding points, keep insync with assets/shaders/vShader.glsl
+	enum BufferBinding : u32 {
+		FrameUniformBinding = 0,
+		ObjectBufferBinding = 1,
+		LightBufferBinding = 2,
+		ClusterRangeBinding = 3,
+		ClusterIndexBinding = 4
+	};
+
+	// std140 per frame block
+	struct FrameUniforms {
+		mat4 toCamera;
+		mat4 toProjection;
+		vec4 cameraPosition;
+		vec4 clusterDepth; // See LightClusters::getDepthParams
+		glm::uvec4 clusterGrid;
+		vec4 viewportSize;
+	};
+
+	// std430 per object entry, indexed by the draw id in the shader
+	struct ObjectUniforms {
+		mat4 toWorld;
+		mat4 modelMatrix;
+	};
+
+	// Geometry uploaded once and referenced by every object with the same geometry key
+	struct SharedGeometry {
+		PoolRange vertexRange;
+		PoolRange elementRange;
+		u32 indexType;
+		i32 indexCount;
+		u32 refCount;
+		AABB bounds;
+		u32 lodCount;
+		LodRange lods[kMaxLodLevels];
+	};
+
+	// Layout fixed by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand {
+		u32 count;
+		u32 instanceCount;
+		u32 firstIndex;
+		i32 baseVertex;
+		u32 baseInstance;
+	};
+
+	// A run of indirect commands sharing the same state, drawn with one glMultiDrawElementsIndirect
+	struct DrawBatch {
+		u32 renderType;
+		u32 indexType;
+		u32 ambientTexture; // 0 when the objects have no texture, the bound one is left alone
+		u32 normalTexture;
+		u32 firstCommand;
+		u32 commandCount;
+	};
+
+	struct RenderStats {
+		u32 objectsDrawn;
+		u32 objectsCulled; // Enabled objects rejected by the frustum test
+		u32 objectsOccluded; // Inside the frustum but hidden behind the depth of an earlier frame
+		u32 drawCalls;
+		u32 sharedGeometries; // Geometry keys currently uploaded
+		f64 submitMs; // CPU time spent issuing the scene draws
+		f64 lightBinningMs;
+		u32 clusterLightIndices; // Light references over all clusters
+		u32 trianglesDrawn;
+		u32 trianglesFullDetail; // What trianglesDrawn would be without LODs
+		u32 prepassDrawCalls;
+		f64 shadedPerPixel; // Fragments the main pass shaded per rendered pixel, read back once the GPU is done
+	};
+
 	extern GLenum GLRenderTypes[3];
 
 	// keep this insync with the IRenderable one, a map would be overkill
@@ -70,6 +191,7 @@ namespace NoxEngine {
 		void clearObject();
 
 		void addLights(Entity *ent);
+		void removeLight(Entity *ent);
 		
 		// Program handle
 		inline void setProgram(GLProgram *programIncome) { program = programIncome;}
@@ -83,17 +205,36 @@ namespace NoxEngine {
 		void fillBackground(i32 hex);
 
 		// Get the texture of the framebuffer the renderer uses
-		inline GLuint getTexture() { return textureToRenderTo; }
+		inline GLuint getTexture() { return isUpscaling() ? outputTexture : textureToRenderTo; }
+		// Only the render size part of it is written, see getRenderWidth
 		inline GLuint getDepthTexture() { return depthStencilTexture; }
 		void updateTextureSizes(u32 width, u32 height);
 
+		// Fraction of the output size the scene is drawn at, the upscale pass makes up the rest
+		void setRenderScale(f32 scale);
+		inline f32 getRenderScale() const { return renderScale; }
+		inline u32 getRenderWidth() const { return renderWidth; }
+		inline u32 getRenderHeight() const { return renderHeight; }
+		inline bool isUpscaling() const { return renderWidth != w || renderHeight != h; }
+		// Feeds a frame time to the dynamic resolution controller and applies the scale it picks
+		void updateRenderScale(f64 frameMs);
+		inline DynamicResolution& getDynamicResolution() { return dynamicResolution; }
+		inline void setUpscaleSharpness(f32 sharpness) { upscaleSharpness = sharpness; }
+		inline f32 getUpscaleSharpness() const { return upscaleSharpness; }
+		// Scales the drawn part of the scene up to the output texture, call after draw()
+		void upscaleScene();
+
 		// Functions updating parts of the shaders
 
 		void updateProjection(i32 w, i32 h);
 
 		inline void setFrameBufferToDefault() { curFBO = 0; setRenderTarget(); }
 		inline void setFrameBufferToTexture() { curFBO = FBO; setRenderTarget(); }
-		inline void setRenderTarget() { glBindFramebuffer(GL_FRAMEBUFFER, curFBO); }
+		inline void setRenderTarget() {
+			GLStateCache::Instance()->bindFramebuffer(curFBO);
+			if (curFBO == FBO) glViewport(0, 0, renderWidth, renderHeight);
+			else glViewport(0, 0, w, h);
+		}
 
 		inline mat4 getProjMatr() { return projection; }
 		inline mat4 getCameraMatr() { return camera->getCameraTransf(); }
@@ -106,14 +247,52 @@ namespace NoxEngine {
 		// Updates Camera with new camera
 		void updateCamera(Camera* camera);
 
-		// Updates the view transformation using the current camera
+		// Updates the view transformation using the current camera, draw() copies it to the GPU
 		void updateCamera();
 
-		void _change_num_of_light(u32 num) { program->changeLightNum(num); }
-
-		inline const Map<u32, RendObj>& getObjects() const { return objects; };
+		inline const SlotMap<RendObj>& getObjects() const { return objects; };
+		inline const GeometryStats& getGeometryStats() const { return geometryStats; };
+		inline const RenderStats& getRenderStats() const { return renderStats; };
+		inline const TextureCache& getTextureCache() const { return textureCache; };
+		// Milliseconds per frame spent copying decoded textures to the GPU
+		inline void setTextureUploadBudget(f64 milliseconds) { textureCache.setUploadBudget(milliseconds); };
+
+		// Switch between one glMultiDrawElementsIndirect per state batch and one draw per object
+		inline void setIndirectDraw(bool enabled) { useIndirectDraw = enabled; };
+		inline bool isIndirectDraw() const { return useIndirectDraw; };
+		inline void setFrustumCulling(bool enabled) { useFrustumCulling = enabled; };
+		inline bool isFrustumCulling() const { return useFrustumCulling; };
+		// Objects hidden in the Hi-Z pyramid of an earlier frame are left out of the draw list
+		inline void setOcclusionCulling(bool enabled) { useOcclusionCulling = enabled; if (!enabled) hiZ->clear(); };
+		inline bool isOcclusionCulling() const { return useOcclusionCulling; };
+		// Largest error in pixels a level of detail may show, 0 draws everything at full detail
+		inline void setLodPixelError(f32 pixels) { lodPixelError = pixels; };
+		inline f32 getLodPixelError() const { return lodPixelError; };
+		// Lay down depth with a trivial program first, the main pass then only shades the nearest fragment
+		inline void setDepthPrepass(bool enabled) { useDepthPrepass = enabled; };
+		inline bool isDepthPrepass() const { return useDepthPrepass; };
+		// Without the pre-pass, sort the main pass by coarse depth before state so early-Z rejects more
+		inline void setFrontToBack(bool enabled) { useFrontToBack = enabled; };
+		inline bool isFrontToBack() const { return useFrontToBack; };
+		// Draw how many fragments the main pass shades per pixel instead of the scene
+		inline void setOverdrawView(bool enabled) { showOverdraw = enabled; };
+		inline bool isOverdrawView() const { return showOverdraw; };
+		// Ground grid on y = 0, drawn over the scene without any geometry in the pools
+		inline void setGridVisible(bool visible) { showGrid = visible; };
+		inline bool isGridVisible() const { return showGrid; };
+		inline void setGridSpacing(f32 spacing) { gridSpacing = spacing; };
+		inline f32 getGridSpacing() const { return gridSpacing; };
+		inline void setGridFadeDistance(f32 distance) { gridFadeDistance = distance; };
+		inline f32 getGridFadeDistance() const { return gridFadeDistance; };
+		void logGeometryStats();
 
 		void updateObjectTransformation(glm::mat4 transformation, u32 rendObjId);
+
+		// Runs on the simulation thread: copies object transforms, animations and light positions out of the
+		// entities. Only reads handles and entities of the objects, those don't change while a simulation runs
+		void recordRenderPacket(RenderPacket &packet) const;
+		// Main thread, before draw(): refits the objects and lights the packet moved
+		void applyRenderPacket(const RenderPacket &packet);
 		void changeTexture(Entity *ent);
 		bool hasRendObj(u32 id);
 
@@ -144,47 +323,138 @@ namespace NoxEngine {
 
 		// The cur camera
 		Camera* camera;
-		Map<u32, RendObj> objects;
+		// Dense so draw() walks contiguous memory, IRenderable::rendObjId holds the handle
+		SlotMap<RendObj> objects;
 		Array<RendObj> perm_objects;
 
 		Array<Entity* > lightSources;
 
-		// Global buffers of attributes
-		GLuint VBO;
-		GLuint NBO;
-		GLuint TCBO;
+		// Light data, indexed like lightSources. Entries changed since the last draw are in [lightsDirtyBegin, lightsDirtyEnd)
+		GLuint lightSSBO;
+		u32 lightSSBOCapacity;
+		Array<LightUniforms> lightUniforms;
+		u32 lightsDirtyBegin;
+		u32 lightsDirtyEnd;
+		u32 lightSetVersion; // Bumped whenever lightSources changes, see RenderPacket
+		LightClusters *lightClusters;
+
+		// Global interleaved vertex and index buffers, objects get a range in them when added
+		GeometryPool *vertexPool;
+		GeometryPool *elementPool;
 		GLuint VAO;
-		GLuint EBO;
-		GLuint TANBO;
 		GLuint FBO;
 
-		i32 numberOfVertices;
-		i32 numberOfNormals;
-		i32 numberOfElements;
-		i32 numOfTexCoords;
-		i32 numOfTangents;
-
-		Array<vec3> vertices;
-		Array<vec3> normals;
-		Array<vec2> texCoords;
-		Array<vec3> tangents;
-		Array<i32> elements;
-
 		// Buffer and texture to render to.
 		GLuint textureToRenderTo;
 		GLuint depthStencilTexture;
 		GLuint tex;
 		GLuint curFBO;
 
+		// The scene targets are allocated at w x h but only drawn into up to renderWidth x renderHeight.
+		// Below full size upscaleScene() fills outputTexture, which is w x h
+		f32 renderScale;
+		u32 renderWidth;
+		u32 renderHeight;
+		GLuint outputFBO;
+		GLuint outputTexture;
+		GLuint upscaleVAO;
+		GLuint upscaleIndexBuffer;
+		FullscreenShader *upscaler;
+		f32 upscaleSharpness;
+		DynamicResolution dynamicResolution;
+
 		vec3 color;
 
-		// Create Arrays of data
-		void createVertexArray(IRenderable* mesh);
-		void createNormalsArray(IRenderable* mesh);
-		void createTexCoordArray(IRenderable* mesh);
-		void createElementArray(IRenderable* mesh);
+		GeometryStats geometryStats;
+		TextureCache textureCache;
+		Map<String, SharedGeometry> sharedGeometry;
+
+		// Per frame and per object shader data, both written into the StreamBuffer once per frame.
+		// Draw ids are the same every frame and stay in their own buffer
+		GLuint drawIdBuffer;
+		u32 drawIdCapacity;
+
+		FrameUniforms frameUniforms;
+		Array<ObjectUniforms> objectUniforms;
+		Array<const RendObj*> drawList;
+		Array<const RendObj*> sortedDrawList;
+		RenderQueue renderQueue;
+
+		// Indirect draw path
+		bool useIndirectDraw;
+		u32 indirectOffset; // Of this frame's commands in the StreamBuffer
+		Array<DrawElementsIndirectCommand> drawCommands;
+		Array<DrawBatch> drawBatches;
+		u32 prepassBatchCount; // Leading entries of drawBatches that belong to the depth pre-pass
+
+		// Depth pre-pass, drawn in its own front to back order. Its draw ids are streamed every frame
+		// instead of coming from the identity drawIdBuffer and point back at the objects' entries in drawList
+		bool useDepthPrepass;
+		bool useFrontToBack;
+		bool showOverdraw;
+		GLProgram *depthProgram;
+		GLProgram *overdrawProgram;
+		Array<const RendObj*> prepassList;
+		Array<u32> prepassDrawIds;
+		Array<u32> drawListPosition; // Where each entry of the unsorted drawList ended up
+		RenderQueue prepassQueue;
+
+		// GL_SAMPLES_PASSED over the main pass, a new one is only started once the last was read
+		GLuint shadedQuery;
+		bool shadedQueryPending;
+
+		RenderStats renderStats;
+
+		// World space bounds of every object in objects, queried with the camera frustum in draw()
+		bool useFrustumCulling;
+		AABBTree cullTree;
+		Array<u32> visibleObjects; // Handles into objects, the proxies' user data
+
+		f32 lodPixelError;
+
+		// Analytic grid, a fullscreen quad on upscaleVAO after the main pass
+		bool showGrid;
+		f32 gridSpacing;
+		f32 gridFadeDistance;
+		GLProgram *gridProgram;
+
+		// Built from the scene depth after every draw, tested against in the next ones
+		bool useOcclusionCulling;
+		HiZBuffer *hiZ;
+
+		// Pack the mesh into PackedVertex/index data and upload it into its range of the pools
+		void createVertexArray(IRenderable* mesh, PoolRange range);
+		void createElementArray(IRenderable* mesh, const RendObj &obj);
+		void setupVertexFormat();
+		void setupShaderBuffers();
+		void uploadObjectUniforms();
+		void uploadLights();
+		void markLightDirty(u32 lightInd);
+		void drawRendObj(const RendObj &obj, u32 drawId, u32 instanceCount);
+		void drawDirect(const Array<const RendObj*> &list, bool withTextures);
+		void drawIndirect(u32 firstBatch, u32 endBatch);
+		void buildDrawBatches(const Array<const RendObj*> &list, bool withTextures);
+		void uploadDrawCommands();
+		void drawDepthPrepass();
+		void drawMainPass();
+		void drawGrid();
+		void readShadedFragments();
+		void bindRendObjTextures(u32 ambientTexture, u32 normalTexture);
+		bool isRendObjVisible(const RendObj &obj);
+		bool isRendObjOccluded(const RendObj &obj) const;
+		// Coarsest level whose error projects to at most lodPixelError pixels
+		u32 selectLod(const RendObj &obj, const vec3 &cameraPosition, f32 pixelsPerUnit) const;
+		// The object's transform component if it has an enabled one
+		TransformComponent* getTransform(const RendObj &obj) const;
+		void refitRendObj(RendObj &obj, const mat4 &worldTransform, u32 version);
+		void setLightPosition(u32 lightInd, const vec3 &worldPosition);
+		void gatherVisibleObjects();
+		// Orders drawList by RenderQueue key, state first, then geometry, then front to back.
+		// Also builds prepassList when the pre-pass is on
+		void sortDrawList();
 
 		RendObj createRendObject(IRenderable *mesh);
+		void releaseRendObject(RendObj &obj);
 
 		// This atribute is needed for Normal Mapping. 
 		// Basically, need to transform the normals in the map into tangent space (space of the primitive (triangle))
@@ -192,18 +462,17 @@ namespace NoxEngine {
 		//  - callculate tangents to vertices and submit them in the shader
 		//  - in shader create transformation matrices using them. 
 		// More in detail in the report section on Normal Mapping
-		void createTangents(IRenderable* mesh); 
-		GLuint setTexture(const String texturePath, const char* uniName, i32 num);
+		Array<vec3> createTangents(IRenderable* mesh); 
+		GLuint setTexture(const String texturePath, const char* uniName, i32 num, u32 placeholder = TextureCache::WhitePlaceholder);
 
 		void setupSkybox();
+		void setupUpscale();
+		void setupDepthPrepass();
 		void skyboxLoadTexture(); 
 
-		u32 nextObjectId;
-
 		public:
-			
-		void _change_num_of_lights_remove_this(u32 num) { program->changeLightNum(num); updateProgram(); }
 
+		// Only write the CPU copy, draw() uploads the changed lights in one go
 		void updateLightPos(u32 lightInd);
 		void updateLightMaterial(u32 lightInd);
 		u32 getNumLights() { return lightSources.size(); }
@@ -35,6 +35,9 @@ namespace NoxEngine {
 		// Add an entity of a preset type, so it has components predefined in it
 		void addEntity(NoxEngineGUI::PresetObject obj);
 
+		// Scatter point lights with random colours in the box, always the same ones for a given count
+		void addPointLights(u32 count, const vec3 &min, const vec3 &max, f32 range);
+
 		//void removeEntity(u32 entID);
 
 		// Return a list of entities that have the specified components
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Managers/Singleton.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	// Part of the stream buffer handed out for this frame, data is mapped and written with plain memcpy.
+	// buffer can change from one frame to the next when the stream buffer grows, bind with what is here
+	struct StreamRange {
+		GLuint buffer;
+		u32 offset; // In bytes from the start of buffer
+		u32 size;
+		void *data;
+	};
+
+	struct StreamBufferStats {
+		u32 frameCapacity; // Bytes one frame can allocate before the buffer grows
+		u32 lastFrameBytes;
+		u32 peakFrameBytes;
+		u32 grows;
+		f64 waitMs; // Blocked on the GPU at the start of the last frame, 0 unless it's FrameCount frames behind
+	};
+
+	/*
+	 * One buffer for the data the CPU rewrites every frame: the frame block, object matrices, draw commands,
+	 * light cluster lists. It is mapped once with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT and split in
+	 * FrameCount regions, each frame bump-allocates from its own region while the GPU still reads the
+	 * regions of the frames before. A fence at the end of a frame guards its region, it is waited on only
+	 * when the region comes round again, so the CPU never stalls unless it gets FrameCount frames ahead.
+	 * Ranges are only valid in the frame they were allocated in. A frame that doesn't fit doubles the
+	 * buffer, the old one is deleted at the next frame, GL keeps it alive until the GPU is done with it.
+	 * */
+	class StreamBuffer : public Singleton<StreamBuffer> {
+		friend class Singleton<StreamBuffer>;
+
+		public:
+			static const u32 FrameCount = 3;
+			static const u32 InitialFrameCapacity = 1 << 20;
+
+			~StreamBuffer();
+
+			// Call once per frame before the first allocation, fences the last frame's region and waits
+			// for the next one if the GPU still reads it
+			void nextFrame();
+
+			// 0 aligns for uniform and shader storage binding, enough for any other use too
+			StreamRange allocate(u32 bytes, u32 alignment = 0);
+			// allocate and copy bytes of data into the range
+			StreamRange upload(const void *data, u32 bytes, u32 alignment = 0);
+
+			inline const StreamBufferStats& getStats() const { return _stats; }
+
+		private:
+			StreamBuffer();
+
+			void create(u32 frameCapacity);
+
+			GLuint _buffer;
+			u8 *_mapped;
+			u32 _frameCapacity;
+			u32 _region;
+			u32 _offset; // Bytes used in the current region
+			GLsync _fences[FrameCount];
+			Array<GLuint> _retired; // Replaced by a larger buffer this frame, deleted at the next
+			u32 _alignment;
+			StreamBufferStats _stats;
+	};
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Utils/ThreadPool.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	/*
+	 * GL textures shared by path.
+	 * Paths are made canonical so "a/../tex.png" and "tex.png" end up as one texture,
+	 * every acquire has to be matched by a release and the texture is deleted with its last user.
+	 *
+	 * Files are decoded on worker threads. Until then the texture holds a single texel of the placeholder
+	 * colour, update() then streams the pixels through a ring of pixel unpack buffers into the same handle,
+	 * spending at most the upload budget per frame so big images are spread over several frames.
+	 * */
+	class TextureCache {
+		public:
+			static const u32 WhitePlaceholder = 0xFFFFFF;
+			static const u32 FlatNormalPlaceholder = 0x8080FF;
+
+			TextureCache();
+			~TextureCache();
+
+			// Returns the texture for the path, the first acquire queues the file for decoding
+			GLuint acquire(const String &path, u32 placeholder = WhitePlaceholder);
+			void release(GLuint texture);
+			void clear();
+
+			// Uploads decoded images, call once per frame on the GL thread
+			void update();
+
+			inline void setUploadBudget(f64 milliseconds) { _uploadBudgetMs = milliseconds; }
+			inline f64 getUploadBudget() const { return _uploadBudgetMs; }
+
+			inline u32 getTextureCount() const { return (u32)_entries.size(); }
+			inline u64 getResidentBytes() const { return _residentBytes; }
+			// Textures still showing their placeholder
+			inline u32 getPendingCount() const { return _pendingCount; }
+
+			static String canonicalPath(const String &path);
+
+		private:
+			struct Entry {
+				GLuint texture;
+				u32 refCount;
+				u64 bytes;
+				bool loaded;
+			};
+
+			struct DecodedImage {
+				String path;
+				u8 *pixels; // nullptr if the decode failed
+				i32 width;
+				i32 height;
+				u64 staged; // Bytes already copied into the pixel buffer
+				i32 pixelBuffer; // Ring slot, -1 until one is free
+			};
+
+			struct PixelBuffer {
+				GLuint buffer;
+				u64 capacity;
+				GLsync fence; // Set after the texture upload reading from it, the slot is reused once it signals
+			};
+
+			GLuint createPlaceholder(u32 color);
+			bool stageImage(DecodedImage &image, f64 deadlineMs);
+			void finishUpload(DecodedImage &image, Entry &entry);
+
+			Map<String, Entry> _entries;
+			Map<GLuint, String> _paths; // Reverse lookup for release
+			u64 _residentBytes;
+			u32 _pendingCount;
+
+			f64 _uploadBudgetMs;
+			Array<PixelBuffer> _pixelBuffers;
+			u32 _nextPixelBuffer;
+			std::deque<DecodedImage> _uploads;
+
+			// Filled by the workers, moved to _uploads on the GL thread
+			std::mutex _decodedMutex;
+			Array<DecodedImage> _decoded;
+
+			// Last member so the workers are joined before anything they write to goes away
+			ThreadPool _workers;
+	};
+}
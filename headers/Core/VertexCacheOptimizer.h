@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Core/Types.h>
+
+namespace NoxEngine {
+
+	// Average cache miss ratio, vertices transformed per triangle, of an index list before and after optimizing it
+	struct VertexCacheStats {
+		u32 triangles;
+		f32 acmrBefore;
+		f32 acmrAfter;
+	};
+
+	/*
+	 * Reorders the triangles of an index list for the post-transform vertex cache, after Tom Forsyth's
+	 * "Linear-Speed Vertex Cache Optimisation". Vertices get a score from their position in a simulated LRU
+	 * cache and from how many triangles still use them, the next triangle is the one whose vertices score
+	 * highest. Only triangles touching the cache are rescored, so it runs in linear time.
+	 * Triangles keep their winding, only their order changes.
+	 * */
+	void optimizeVertexCache(Array<i32> &indices, u32 vertexCount);
+
+	// Renumbers vertices in the order the indices first use them, so fetches walk the vertex buffer forward.
+	// remap[old] is the new index, vertices no triangle uses go last
+	void optimizeVertexFetch(Array<i32> &indices, u32 vertexCount, Array<u32> &remap);
+
+	// Vertices transformed per triangle with a FIFO cache of cacheSize entries, 0.5 is the best a mesh can do
+	// and 3 the worst
+	f32 computeAcmr(const Array<i32> &indices, u32 vertexCount, u32 cacheSize = 16);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Core/Types.h>
+
+namespace NoxEngine {
+
+	/*
+	 * Interleaved vertex stored in the Renderer's geometry pool.
+	 * Normals are octahedral encoded into two snorm16, tex coords are two half floats, which brings a vertex
+	 * down to 20 bytes from the 44 bytes of separate float arrays. No tangent, the shaders don't use one.
+	 * */
+	struct PackedVertex {
+		vec3 position;
+		u32 normal;
+		u32 texCoord;
+	};
+
+	static_assert(sizeof(PackedVertex) == 20, "PackedVertex is expected to be tightly packed");
+
+	// Size of a vertex in the old layout: position, normal and tangent as vec3 and a vec2 tex coord
+	constexpr u32 kUnpackedVertexSize = 3 * sizeof(vec3) + sizeof(vec2);
+
+	// Keep insync with the layout qualifiers in assets/shaders/vShader.glsl
+	enum VertexAttribLocation : u32 {
+		PositionAttrib = 0,
+		NormalAttrib,
+		TexCoordAttrib,
+		DrawIdAttrib = 4 // Per instance, sourced from an iota buffer and offset by the draw's base instance
+	};
+
+	u32 packOctahedral(vec3 dir);
+	vec3 unpackOctahedral(u32 packed);
+	u32 packTexCoord(vec2 uv);
+
+	PackedVertex packVertex(const vec3 &position, const vec3 &normal, const vec2 &texCoord);
+}
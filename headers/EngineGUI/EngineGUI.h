@@ -64,6 +64,9 @@ namespace NoxEngineGUI {
 		FullscreenShader,
 		PostPorcessors,
 
+		// Profiling
+		GpuProfilerPanel,
+
 	};
 
 	// Assign the panel name to the panel's enum
@@ -79,6 +82,7 @@ namespace NoxEngineGUI {
 		{ PanelName::SkyboxSettings, "Skybox Settings" },
 		{ PanelName::FullscreenShader,  "Fullscreen Shader" },
 		{ PanelName::PostPorcessors,  "Post Processors" },
+		{ PanelName::GpuProfilerPanel,  "GPU Profiler" },
 	};
 
 	static ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_None;
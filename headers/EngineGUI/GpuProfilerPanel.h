@@ -0,0 +1,9 @@
+#pragma once
+
+// Core GUI
+#include "EngineGUI.h"
+#include <Core/GameState.h>
+
+namespace NoxEngineGUI {
+	void updateGpuProfilerPanel(NoxEngine::GameState* state);
+}
@@ -6,42 +6,45 @@
 
 namespace NoxEngine {
 
+	// TextureInput source of the Renderer's output, other sources index GameState::post_processors
+	static const i32 kMainRendererInput = -1;
+
 	struct TextureInput {
-		u32 texture_id;
+		i32 source; // Only earlier passes, a pass's output doesn't exist yet before it runs
 		u32 texture_location;
 	};
 
 	class FullscreenShader : public GLProgram, public IReloadableFile {
 		public:
 
-			FullscreenShader(
-				u32 frame_width = 0,
-				u32 frame_height = 0,
-				const char *name = "PostProcessor"
-			);
+			FullscreenShader(const char *name = "PostProcessor");
 
 			FullscreenShader(const FullscreenShader&);
 			~FullscreenShader();
 			FullscreenShader(
 					const String shader_src,
 					Array<TextureInput> texture_inputs = Array<TextureInput>(),
-					u32 frame_width = 0,
-					u32 frame_height = 0,
 					const char *name = "PostProcessor"
 			);
-			void saveState();
-			void restoreState();
-			void draw(time_type deltaTime);
+			// input_textures holds the texture of each TextureInput, resolved by the PostProcessChain
+			void draw(time_type deltaTime, const Array<u32> &input_textures);
 			bool IsInit() { return inited;};
 
-			void AddInput(u32 texture_id, u32 texture_unit);
+			void AddInput(i32 source, u32 texture_unit);
 			void RemoveInput(i32 input_index);
 
 			bool ChangeShader(String& shader_path);
-			void changeTextureSize(i32 width, i32 height);
+
+			// Target the next draw() renders into, handed out by the PostProcessChain every frame
+			void setOutput(u32 framebuffer, u32 texture, u32 width, u32 height);
+
+			// Fraction of the chain's resolution the pass renders at, 0.5 or 0.25 suit blurs
+			inline void SetResolutionScale(f32 scale) { resolution_scale = scale; }
+			inline f32 GetResolutionScale() const { return resolution_scale; }
 
 			void liveReloadFile(const char *file, LiveReloadEntry *entry) override;
 
+			// 0 if the pass didn't run in the last chain
 			inline u32 GetTexture() { return texture_id; }
 			inline const char* GetShader() const { return fragment_shader.c_str(); };
 			inline const char* GetName() const { return name.c_str(); };
@@ -52,13 +55,10 @@ namespace NoxEngine {
 			String name;
 			u32 frame_width;
 			u32 frame_height;
-			u32 texture_id;
+			f32 resolution_scale;
+			u32 texture_id; // Output target, owned by the PostProcessChain
 			u32 framebuffer_id;
 			Array<TextureInput> texture_inputs;
 			bool inited;
-
-			i32 current_bound_texture;
-			i32 current_bound_framebuffer;
-			i32 current_bound_program;
 	};
 }
@@ -28,7 +28,7 @@
 #include <Components/RenderableComponent.h>
 #include <Components/TransformComponent.h>
 #include <EngineGUI/EngineGUI.h>
-#include <Core/GridObject.h>
+#include <Managers/HeadlessBenchmark.h>
 
 // TODO: move to a config file
 #define WINDOW_WIDTH 1920
@@ -52,6 +52,9 @@ namespace NoxEngine {
 		friend class Singleton<GameManager>;
 
 		public: 
+			// Run without a visible window or GUI, see HeadlessBenchmark. Call before init()
+			void setHeadless(const BenchmarkSettings &settings);
+
 			void init();
 			void update();
 
@@ -102,14 +105,21 @@ namespace NoxEngine {
 			void init_scripts();
 			void init_postprocess();
 
+			void update_time();
+			void update_render_scale();
 			void update_livereloads();
 			void update_inputs();
 			void update_ecs();
 			void update_animation();
+			void update_transforms();
 			void update_audio();
-			void update_renderer();
+			void update_renderer(const RenderPacket &packet);
 			void update_postprocessors();
 			void update_gui();
+			void draw_gui();
+
+			// The part of a frame that runs on FramePipeline's thread
+			void simulate(RenderPacket &packet);
 			
 			void keyboard_callback(GLFWwindow *, i32 key, i32 scan, i32 action, i32 mods);
 
@@ -125,6 +135,14 @@ namespace NoxEngine {
 			ImFont* font;
 			Array<GLProgram> programs;
 			GLProgram *current_program;
+
+			// Dirty transforms gathered by update_transforms, kept to reuse the allocation
+			Array<TransformComponent*> transforms;
+
+			FramePipeline framePipeline;
+
+			// Only set in headless mode
+			HeadlessBenchmark *benchmark;
 			GUIParams ui_params;
 	};
 
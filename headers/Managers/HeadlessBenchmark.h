@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Core/Camera.h>
+#include <Core/Renderer.h>
+#include <Core/FramePipeline.h>
+
+#include <chrono>
+
+namespace NoxEngine {
+
+	struct BenchmarkSettings {
+		u32 frames = 600;
+		u32 width = 1280;
+		u32 height = 720;
+
+		String scenePath; // Empty keeps the default scene
+		String csvPath = "benchmark.csv";
+		String pngDirectory; // Empty writes no images
+		u32 pngInterval = 60; // Every n-th frame is written when pngDirectory is set
+		bool depthPrepass = false;
+		bool occlusionCulling = false;
+		bool showOverdraw = false; // Dumps the overdraw view instead of the scene
+		f32 lodPixelError = 1.0f; // 0 draws everything at full detail
+		u32 cullBenchBoxes = 0; // Set by --cull-bench, runs runCullBenchmark instead of the engine
+		String lodCheckPath; // Set by --lod-check, runs checkLods on it instead of the engine
+
+		// The camera circles target once over the run, always looking at it
+		vec3 orbitTarget = vec3(0.0f);
+		f32 orbitRadius = 150.0f;
+		f32 orbitHeight = 60.0f;
+	};
+
+	struct BenchmarkFrame {
+		f64 frameMs; // CPU time of GameManager::update without the buffer swap
+		f64 submitMs;
+		f64 lightBinningMs;
+		u32 objectsDrawn;
+		u32 objectsCulled;
+		u32 objectsOccluded;
+		u32 drawCalls;
+		u32 trianglesDrawn;
+		f64 shadedPerPixel; // Lags a few frames, see RenderStats
+		u32 bindsIssued;
+		u32 bindsSkipped;
+		f64 simulationMs; // FramePipeline stats, these lag a frame behind the rest
+		f64 overlapMs;
+	};
+
+	/*
+	 * Drives GameManager when it runs without a visible window or GUI: moves the camera along a fixed path,
+	 * times every frame and writes the timings as CSV, optionally with PNGs of the Renderer's target.
+	 * The same settings give the same camera path, so runs can be compared across builds and machines.
+	 * */
+	class HeadlessBenchmark {
+		public:
+			HeadlessBenchmark(const BenchmarkSettings &settings);
+
+			// Fills settings from --headless [--frames n] [--size w h] [--scene path] [--csv path] [--png dir [every]]
+			// or --cull-bench [boxes] or --lod-check [path]. Returns false if --headless isn't on the command line
+			static bool parseArgs(i32 argc, char **argv, BenchmarkSettings &settings);
+
+			// CPU only, needs no window or GL context: times frustum queries on an AABBTree of that many random
+			// boxes against testing every box, and checks the tree finds all of them. Logs the timings
+			static bool runCullBenchmark(u32 boxes);
+
+			void beginFrame(Camera *camera);
+			void endFrame(Renderer *renderer, const FramePacingStats &pacing);
+
+			inline bool isDone() const { return _frame >= _settings.frames; }
+			inline const BenchmarkSettings& getSettings() const { return _settings; }
+
+			bool writeCsv() const;
+
+		private:
+			void writePng(Renderer *renderer) const;
+
+			BenchmarkSettings _settings;
+			Array<BenchmarkFrame> _frames;
+			std::chrono::high_resolution_clock::time_point _frameStart;
+			u32 _frame;
+	};
+}
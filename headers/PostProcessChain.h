@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <FullscreenShader.h>
+#include <glad/glad.h>
+
+namespace NoxEngine {
+
+	struct PostProcessStats {
+		u32 passesRun;
+		u32 passesSkipped; // Nothing reads their output and it isn't shown
+		u32 targets; // In the pool, in use this frame or not
+		u64 pooledBytes;
+		u64 perPassBytes; // What one full resolution target per pass would take
+	};
+
+	/*
+	 * Runs the post processors in order, rendering into targets from a small pool instead of one per pass.
+	 * A pass's target goes back to the pool once the last pass reading it has run, so a straight chain
+	 * ping-pongs between two targets. Passes can render at a fraction of the resolution, targets are only
+	 * shared between passes of the same size. The shown pass keeps its target until the end of the frame,
+	 * a pass nobody reads and that isn't shown is skipped.
+	 * The pool hands out the same targets every frame as long as the passes don't change, so texture ids
+	 * the GUI took from the last frame still point at the right output.
+	 * */
+	class PostProcessChain {
+		public:
+			// Targets unused for this many frames, after a resize or a change to the passes, are deleted
+			static const u32 TargetLifetime = 8;
+
+			PostProcessChain();
+			~PostProcessChain();
+
+			// shownPass is the pass whose output is displayed after the chain, -1 if none
+			void execute(Array<FullscreenShader> &passes, u32 sceneTexture, i32 shownPass, u32 width, u32 height, time_type time);
+
+			// Every pass keeps its own target, for inspecting each output in the editor
+			inline void setKeepOutputs(bool keep) { _keepOutputs = keep; }
+			inline bool isKeepOutputs() const { return _keepOutputs; }
+
+			inline const PostProcessStats& getStats() const { return _stats; }
+
+			void clear();
+
+		private:
+			struct RenderTarget {
+				GLuint framebuffer;
+				GLuint texture;
+				u32 width;
+				u32 height;
+				i32 lastReader; // Index of the last pass reading it this frame, it is free for passes after that
+				u32 lastUsedFrame;
+			};
+
+			u32 acquire(u32 width, u32 height, i32 pass, i32 lastReader);
+			void trim();
+
+			Array<RenderTarget> _targets;
+			Array<i32> _lastReader; // Per pass, -1 if the output is never used
+			Array<u32> _inputTextures;
+			u32 _frame;
+			bool _keepOutputs;
+			PostProcessStats _stats;
+	};
+}
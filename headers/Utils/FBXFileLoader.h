@@ -7,6 +7,14 @@
 namespace NoxEngine {
 	const aiScene* readFBX(const char* filename);
 
+	// Imports every .fbx in directory and logs the vertex cache ACMR of each before and after optimizing it
+	void reportVertexCache(const char* directory);
+
+	// Imports path and checks the LODs of every mesh: each level has about half the triangles of the one
+	// before, only the last one may stop short, and errors grow level by level within lodErrorBound.
+	// Logs the levels of each mesh, returns false if one breaks those rules or the file has no LODs at all
+	bool checkLods(const char* path);
+
 	aiScene* generateAiScene(const MeshScene& meshScene);
 	void exportFBX(aiScene *scene);
 };
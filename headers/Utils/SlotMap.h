@@ -0,0 +1,139 @@
+#pragma once
+
+#include <Core/Types.h>
+#include <Utils/Utils.h>
+
+#include <utility>
+
+namespace NoxEngine {
+
+	/*
+	 * Values packed in one dense array, addressed through stable handles.
+	 * A handle is a slot index in the low bits and the slot's generation in the high bits, removing a value bumps
+	 * the generation so old handles to the slot stop resolving. Removal moves the last value into the hole, so
+	 * iteration order isn't kept and pointers into the map are only good until the next insert or remove.
+	 * */
+	template <typename T>
+	class SlotMap {
+		public:
+			typedef u32 Handle;
+
+			static const u32 IndexBits = 20;
+			static const u32 IndexMask = (1u << IndexBits) - 1;
+			// The last index is never handed out so no handle equals Invalid
+			static const u32 MaxSize = IndexMask;
+			static const Handle Invalid = ~0u;
+
+			SlotMap() : _values(), _valueSlots(), _slots(), _freeHead(Invalid) {}
+
+			Handle insert(const T &value) {
+
+				u32 slotIndex;
+				if (_freeHead != Invalid) {
+					slotIndex = _freeHead;
+					_freeHead = _slots[slotIndex].index;
+				} else {
+					if (_slots.size() >= MaxSize) {
+						LOG_DEBUG("SlotMap is full (%u values)", MaxSize);
+						return Invalid;
+					}
+
+					slotIndex = (u32)_slots.size();
+					_slots.push_back({ 0, 0 });
+				}
+
+				_slots[slotIndex].index = (u32)_values.size();
+				_values.push_back(value);
+				_valueSlots.push_back(slotIndex);
+
+				return slotIndex | (_slots[slotIndex].generation << IndexBits);
+			}
+
+			bool remove(Handle handle) {
+
+				Slot *slot = find(handle);
+				if (slot == nullptr) return false;
+
+				removeAt(slot->index);
+				return true;
+			}
+
+			// Removes the value at a dense index, the last value takes its place
+			void removeAt(u32 index) {
+
+				u32 slotIndex = _valueSlots[index];
+				u32 last = (u32)_values.size() - 1;
+
+				if (index != last) {
+					_values[index] = std::move(_values[last]);
+					_valueSlots[index] = _valueSlots[last];
+					_slots[_valueSlots[index]].index = index;
+				}
+
+				_values.pop_back();
+				_valueSlots.pop_back();
+
+				// Wraps within the generation bits
+				Slot &slot = _slots[slotIndex];
+				slot.generation = (slot.generation + 1) & (~0u >> IndexBits);
+				slot.index = _freeHead;
+				_freeHead = slotIndex;
+			}
+
+			inline T* get(Handle handle) {
+				Slot *slot = find(handle);
+				return slot ? &_values[slot->index] : nullptr;
+			}
+
+			inline const T* get(Handle handle) const {
+				return const_cast<SlotMap*>(this)->get(handle);
+			}
+
+			inline bool contains(Handle handle) const { return get(handle) != nullptr; }
+
+			// Handle of the value at a dense index
+			inline Handle handleAt(u32 index) const {
+				u32 slotIndex = _valueSlots[index];
+				return slotIndex | (_slots[slotIndex].generation << IndexBits);
+			}
+
+			void clear() {
+				for (u32 i = (u32)_values.size(); i > 0; i--) removeAt(i - 1);
+			}
+
+			inline u32 size() const { return (u32)_values.size(); }
+			inline bool empty() const { return _values.empty(); }
+
+			inline T& operator[](u32 index) { return _values[index]; }
+			inline const T& operator[](u32 index) const { return _values[index]; }
+
+			inline typename Array<T>::iterator begin() { return _values.begin(); }
+			inline typename Array<T>::iterator end() { return _values.end(); }
+			inline typename Array<T>::const_iterator begin() const { return _values.begin(); }
+			inline typename Array<T>::const_iterator end() const { return _values.end(); }
+
+		private:
+			struct Slot {
+				u32 index; // Into _values while in use, next free slot while free
+				u32 generation;
+			};
+
+			inline Slot* find(Handle handle) {
+				u32 slotIndex = handle & IndexMask;
+				if (slotIndex >= _slots.size()) return nullptr;
+
+				Slot &slot = _slots[slotIndex];
+				if (slot.generation != handle >> IndexBits) return nullptr;
+
+				// A free slot keeps its generation but points at the free list, not at its value
+				if (slot.index >= _values.size() || _valueSlots[slot.index] != slotIndex) return nullptr;
+
+				return &slot;
+			}
+
+			Array<T> _values;
+			Array<u32> _valueSlots; // Slot of each value, parallel to _values
+			Array<Slot> _slots;
+			u32 _freeHead;
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Core/Types.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+
+namespace NoxEngine {
+
+	/*
+	 * Fixed set of worker threads taking jobs from one FIFO queue.
+	 * Jobs must not touch GL, there is no context on the workers.
+	 * */
+	class ThreadPool {
+		public:
+			// 0 picks one thread less than the hardware has, leaving a core to the main thread
+			ThreadPool(u32 threadCount = 0);
+			~ThreadPool();
+
+			void submit(std::function<void()> job);
+
+			// Drops the jobs that haven't started and waits for the running ones
+			void shutdown();
+
+			inline u32 getThreadCount() const { return (u32)_threads.size(); }
+
+		private:
+			void workerLoop();
+
+			Array<std::thread> _threads;
+			std::deque<std::function<void()>> _jobs;
+			std::mutex _mutex;
+			std::condition_variable _condition;
+			bool _stopping;
+	};
+}
@@ -77,11 +77,15 @@ RenderableComponent::RenderableComponent(const RenderableComponent &other) :
 {
 	//id = ComponentType::RenderableType;
 
-	vertices	= other.vertices;
-	texCoords	= other.texCoords;
-	normals		= other.normals;
-	faces		= other.faces;
-	indices		= other.indices;
+	// Through the getters, other may be a Mesh sharing its geometry
+	vertices	= other.getVertices();
+	texCoords	= other.getTexCoords();
+	normals		= other.getNormals();
+	faces		= other.getFaces();
+	indices		= other.getIndices();
+	lods		= other.getLods();
+
+	geometryKey = other.geometryKey;
 
 	has_texture = other.has_texture;
 	has_normal	= other.has_normal;
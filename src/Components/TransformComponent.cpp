@@ -1,8 +1,16 @@
 #include <Components/TransformComponent.h>
 
+#include <cmath>
+
 using namespace NoxEngine;
 
-TransformComponent::TransformComponent(f32 newx, f32 newy, f32 newz)
+// 0 and ~0 are left to users of the version for "no transform" and "stale"
+static u32 nextVersion = 1;
+
+TransformComponent::TransformComponent(f32 newx, f32 newy, f32 newz) :
+	worldMatrix(1.0f),
+	version(0),
+	dirty(true)
 {
 	//id = ComponentType::TransformType;
 	x = newx;
@@ -16,4 +24,68 @@ TransformComponent::TransformComponent(f32 newx, f32 newy, f32 newz)
 	sx = 1.0f;
 	sy = 1.0f;
 	sz = 1.0f;
-}
\ No newline at end of file
+}
+
+const mat4& TransformComponent::getWorldMatrix() {
+	if (dirty) updateWorldMatrix();
+	return worldMatrix;
+}
+
+vec3 TransformComponent::getForward() {
+	const mat4 &world = getWorldMatrix();
+	return sz != 0.0f ? vec3(world[2]) / sz : vec3(0.0f, 0.0f, 1.0f);
+}
+
+vec3 TransformComponent::getUp() {
+	const mat4 &world = getWorldMatrix();
+	return sy != 0.0f ? vec3(world[1]) / sy : vec3(0.0f, 1.0f, 0.0f);
+}
+
+// translate * eulerAngleXYZ * scale written out, scaling the rotation columns instead of multiplying.
+// Sines and cosines are of the negated angles, the same convention as glm::eulerAngleXYZ
+void TransformComponent::writeWorldMatrix(f32 s1, f32 s2, f32 s3, f32 c1, f32 c2, f32 c3) {
+
+	worldMatrix[0] = vec4(c2 * c3, -c1 * s3 + s1 * s2 * c3, s1 * s3 + c1 * s2 * c3, 0.0f) * sx;
+	worldMatrix[1] = vec4(c2 * s3, c1 * c3 + s1 * s2 * s3, -s1 * c3 + c1 * s2 * s3, 0.0f) * sy;
+	worldMatrix[2] = vec4(-s2, s1 * c2, c1 * c2, 0.0f) * sz;
+	worldMatrix[3] = vec4(x, y, z, 1.0f);
+
+	version = nextVersion++;
+	if (nextVersion == ~0u) nextVersion = 1;
+	dirty = false;
+}
+
+void TransformComponent::updateWorldMatrix() {
+	writeWorldMatrix(std::sin(-rx), std::sin(-ry), std::sin(-rz), std::cos(-rx), std::cos(-ry), std::cos(-rz));
+}
+
+void TransformComponent::updateWorldMatrices(const Array<TransformComponent*> &transforms) {
+
+	// Structure of arrays so the sin/cos and matrix loops run over plain floats, reused between frames
+	static Array<TransformComponent*> dirtyTransforms;
+	static Array<f32> sines, cosines;
+
+	dirtyTransforms.clear();
+	for (TransformComponent *trans : transforms) {
+		if (trans->dirty) dirtyTransforms.push_back(trans);
+	}
+
+	u32 count = (u32)dirtyTransforms.size();
+	if (count == 0) return;
+
+	sines.resize(count * 3);
+	cosines.resize(count * 3);
+
+	for (u32 i = 0; i < count; i++) {
+		const TransformComponent *trans = dirtyTransforms[i];
+		sines[i * 3 + 0] = std::sin(-trans->rx); cosines[i * 3 + 0] = std::cos(-trans->rx);
+		sines[i * 3 + 1] = std::sin(-trans->ry); cosines[i * 3 + 1] = std::cos(-trans->ry);
+		sines[i * 3 + 2] = std::sin(-trans->rz); cosines[i * 3 + 2] = std::cos(-trans->rz);
+	}
+
+	for (u32 i = 0; i < count; i++) {
+		dirtyTransforms[i]->writeWorldMatrix(
+				sines[i * 3 + 0], sines[i * 3 + 1], sines[i * 3 + 2],
+				cosines[i * 3 + 0], cosines[i * 3 + 1], cosines[i * 3 + 2]);
+	}
+}
@@ -0,0 +1,413 @@
+#include <Core/AABBTree.h>
+
+#include <algorithm>
+
+using namespace NoxEngine;
+
+AABB AABB::transformed(const mat4 &m) const {
+
+	vec3 center = (min + max) * 0.5f;
+	vec3 extents = (max - min) * 0.5f;
+
+	vec3 newCenter = vec3(m * vec4(center, 1.0f));
+	vec3 newExtents;
+
+	// Each world axis gets the absolute contribution of every local axis (column i of m)
+	for (i32 i = 0; i < 3; i++) {
+		newExtents[i] =
+			glm::abs(m[0][i]) * extents.x +
+			glm::abs(m[1][i]) * extents.y +
+			glm::abs(m[2][i]) * extents.z;
+	}
+
+	return { newCenter - newExtents, newCenter + newExtents };
+}
+
+AABB AABB::merged(const AABB &other) const {
+	return { glm::min(min, other.min), glm::max(max, other.max) };
+}
+
+AABB AABB::expanded(f32 margin) const {
+	return { min - vec3(margin), max + vec3(margin) };
+}
+
+bool AABB::contains(const AABB &other) const {
+	return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+		max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+}
+
+f32 AABB::surfaceArea() const {
+	vec3 d = max - min;
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+AABB NoxEngine::computeAABB(const Array<vec3> &points) {
+
+	if (points.empty()) return { vec3(0.0f), vec3(0.0f) };
+
+	AABB box = { points[0], points[0] };
+	for (const vec3 &p : points) {
+		box.min = glm::min(box.min, p);
+		box.max = glm::max(box.max, p);
+	}
+
+	return box;
+}
+
+
+Frustum::Frustum(const mat4 &m) {
+
+	// Gribb/Hartmann, glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+	vec4 row0 = vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+	vec4 row1 = vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+	vec4 row2 = vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+	vec4 row3 = vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	planes[0] = row3 + row0; // left
+	planes[1] = row3 - row0; // right
+	planes[2] = row3 + row1; // bottom
+	planes[3] = row3 - row1; // top
+	planes[4] = row3 + row2; // near
+	planes[5] = row3 - row2; // far
+
+	for (i32 i = 0; i < 6; i++) {
+		planes[i] /= glm::length(vec3(planes[i]));
+	}
+}
+
+Frustum::Result Frustum::test(const AABB &box) const {
+
+	Result result = Inside;
+
+	for (i32 i = 0; i < 6; i++) {
+		const vec4 &p = planes[i];
+
+		// Corner furthest along the plane normal, and the one furthest against it
+		vec3 positive = vec3(p.x >= 0.0f ? box.max.x : box.min.x, p.y >= 0.0f ? box.max.y : box.min.y, p.z >= 0.0f ? box.max.z : box.min.z);
+		vec3 negative = vec3(p.x >= 0.0f ? box.min.x : box.max.x, p.y >= 0.0f ? box.min.y : box.max.y, p.z >= 0.0f ? box.min.z : box.max.z);
+
+		if (glm::dot(vec3(p), positive) + p.w < 0.0f) return Outside;
+		if (glm::dot(vec3(p), negative) + p.w < 0.0f) result = Intersects;
+	}
+
+	return result;
+}
+
+
+AABBTree::AABBTree(f32 margin) :
+	_nodes(),
+	_stack(),
+	_root(NullNode),
+	_freeList(NullNode),
+	_proxyCount(0),
+	_margin(margin)
+{ }
+
+i32 AABBTree::allocateNode() {
+
+	if (_freeList == NullNode) {
+		_nodes.push_back({});
+		_nodes.back().height = -1;
+		_freeList = (i32)_nodes.size() - 1;
+		_nodes.back().parent = NullNode;
+	}
+
+	i32 node = _freeList;
+	_freeList = _nodes[node].parent;
+
+	_nodes[node].parent = NullNode;
+	_nodes[node].left = NullNode;
+	_nodes[node].right = NullNode;
+	_nodes[node].height = 0;
+	_nodes[node].userData = 0;
+
+	return node;
+}
+
+void AABBTree::freeNode(i32 node) {
+	_nodes[node].parent = _freeList;
+	_nodes[node].height = -1;
+	_freeList = node;
+}
+
+i32 AABBTree::createProxy(const AABB &box, u32 userData) {
+
+	i32 proxy = allocateNode();
+	_nodes[proxy].box = box.expanded(_margin);
+	_nodes[proxy].userData = userData;
+
+	insertLeaf(proxy);
+	_proxyCount++;
+
+	return proxy;
+}
+
+void AABBTree::destroyProxy(i32 proxy) {
+	if (proxy == NullNode) return;
+
+	removeLeaf(proxy);
+	freeNode(proxy);
+	_proxyCount--;
+}
+
+bool AABBTree::moveProxy(i32 proxy, const AABB &box) {
+
+	// Still inside the enlarged box, nothing to do
+	if (_nodes[proxy].box.contains(box)) return false;
+
+	removeLeaf(proxy);
+	_nodes[proxy].box = box.expanded(_margin);
+	insertLeaf(proxy);
+
+	return true;
+}
+
+void AABBTree::clear() {
+	_nodes.clear();
+	_root = NullNode;
+	_freeList = NullNode;
+	_proxyCount = 0;
+}
+
+i32 AABBTree::getHeight() const {
+	return _root == NullNode ? 0 : _nodes[_root].height;
+}
+
+void AABBTree::insertLeaf(i32 leaf) {
+
+	if (_root == NullNode) {
+		_root = leaf;
+		_nodes[_root].parent = NullNode;
+		return;
+	}
+
+	// Walk down picking the child with the lowest cost increase
+	AABB leafBox = _nodes[leaf].box;
+	i32 index = _root;
+
+	while (!_nodes[index].isLeaf()) {
+
+		i32 left = _nodes[index].left;
+		i32 right = _nodes[index].right;
+
+		f32 area = _nodes[index].box.surfaceArea();
+		f32 combinedArea = _nodes[index].box.merged(leafBox).surfaceArea();
+
+		// Cost of making a new parent here, and the cost pushed down to the children
+		f32 cost = 2.0f * combinedArea;
+		f32 inheritanceCost = 2.0f * (combinedArea - area);
+
+		f32 costLeft = leafBox.merged(_nodes[left].box).surfaceArea() + inheritanceCost;
+		if (!_nodes[left].isLeaf()) costLeft -= _nodes[left].box.surfaceArea();
+
+		f32 costRight = leafBox.merged(_nodes[right].box).surfaceArea() + inheritanceCost;
+		if (!_nodes[right].isLeaf()) costRight -= _nodes[right].box.surfaceArea();
+
+		if (cost < costLeft && cost < costRight) break;
+
+		index = costLeft < costRight ? left : right;
+	}
+
+	i32 sibling = index;
+
+	// New parent for the sibling and the leaf
+	i32 oldParent = _nodes[sibling].parent;
+	i32 newParent = allocateNode();
+	_nodes[newParent].parent = oldParent;
+	_nodes[newParent].box = leafBox.merged(_nodes[sibling].box);
+	_nodes[newParent].height = _nodes[sibling].height + 1;
+	_nodes[newParent].left = sibling;
+	_nodes[newParent].right = leaf;
+	_nodes[sibling].parent = newParent;
+	_nodes[leaf].parent = newParent;
+
+	if (oldParent != NullNode) {
+		if (_nodes[oldParent].left == sibling) _nodes[oldParent].left = newParent;
+		else _nodes[oldParent].right = newParent;
+	} else {
+		_root = newParent;
+	}
+
+	// Walk back up fixing heights and boxes
+	index = _nodes[leaf].parent;
+	while (index != NullNode) {
+		index = balance(index);
+
+		i32 left = _nodes[index].left;
+		i32 right = _nodes[index].right;
+
+		_nodes[index].height = 1 + std::max(_nodes[left].height, _nodes[right].height);
+		_nodes[index].box = _nodes[left].box.merged(_nodes[right].box);
+
+		index = _nodes[index].parent;
+	}
+}
+
+void AABBTree::removeLeaf(i32 leaf) {
+
+	if (leaf == _root) {
+		_root = NullNode;
+		return;
+	}
+
+	i32 parent = _nodes[leaf].parent;
+	i32 grandParent = _nodes[parent].parent;
+	i32 sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+	if (grandParent == NullNode) {
+		_root = sibling;
+		_nodes[sibling].parent = NullNode;
+		freeNode(parent);
+		return;
+	}
+
+	// The sibling takes the parent's place
+	if (_nodes[grandParent].left == parent) _nodes[grandParent].left = sibling;
+	else _nodes[grandParent].right = sibling;
+	_nodes[sibling].parent = grandParent;
+	freeNode(parent);
+
+	i32 index = grandParent;
+	while (index != NullNode) {
+		index = balance(index);
+
+		i32 left = _nodes[index].left;
+		i32 right = _nodes[index].right;
+
+		_nodes[index].box = _nodes[left].box.merged(_nodes[right].box);
+		_nodes[index].height = 1 + std::max(_nodes[left].height, _nodes[right].height);
+
+		index = _nodes[index].parent;
+	}
+}
+
+// Rotate a if it is imbalanced, returns the index of the new subtree root
+i32 AABBTree::balance(i32 a) {
+
+	Node &A = _nodes[a];
+	if (A.isLeaf() || A.height < 2) return a;
+
+	i32 b = A.left;
+	i32 c = A.right;
+	i32 diff = _nodes[c].height - _nodes[b].height;
+
+	// Promote c
+	if (diff > 1) {
+		i32 f = _nodes[c].left;
+		i32 g = _nodes[c].right;
+
+		// Swap a and c
+		_nodes[c].left = a;
+		_nodes[c].parent = _nodes[a].parent;
+		_nodes[a].parent = c;
+
+		if (_nodes[c].parent != NullNode) {
+			if (_nodes[_nodes[c].parent].left == a) _nodes[_nodes[c].parent].left = c;
+			else _nodes[_nodes[c].parent].right = c;
+		} else {
+			_root = c;
+		}
+
+		// Keep the taller of f and g under c
+		if (_nodes[f].height > _nodes[g].height) {
+			_nodes[c].right = f;
+			_nodes[a].right = g;
+			_nodes[g].parent = a;
+		} else {
+			_nodes[c].right = g;
+			_nodes[a].right = f;
+			_nodes[f].parent = a;
+		}
+
+		_nodes[a].box = _nodes[b].box.merged(_nodes[_nodes[a].right].box);
+		_nodes[c].box = _nodes[a].box.merged(_nodes[_nodes[c].right].box);
+
+		_nodes[a].height = 1 + std::max(_nodes[b].height, _nodes[_nodes[a].right].height);
+		_nodes[c].height = 1 + std::max(_nodes[a].height, _nodes[_nodes[c].right].height);
+
+		return c;
+	}
+
+	// Promote b
+	if (diff < -1) {
+		i32 d = _nodes[b].left;
+		i32 e = _nodes[b].right;
+
+		// Swap a and b
+		_nodes[b].left = a;
+		_nodes[b].parent = _nodes[a].parent;
+		_nodes[a].parent = b;
+
+		if (_nodes[b].parent != NullNode) {
+			if (_nodes[_nodes[b].parent].left == a) _nodes[_nodes[b].parent].left = b;
+			else _nodes[_nodes[b].parent].right = b;
+		} else {
+			_root = b;
+		}
+
+		// Keep the taller of d and e under b
+		if (_nodes[d].height > _nodes[e].height) {
+			_nodes[b].right = d;
+			_nodes[a].left = e;
+			_nodes[e].parent = a;
+		} else {
+			_nodes[b].right = e;
+			_nodes[a].left = d;
+			_nodes[d].parent = a;
+		}
+
+		_nodes[a].box = _nodes[c].box.merged(_nodes[_nodes[a].left].box);
+		_nodes[b].box = _nodes[a].box.merged(_nodes[_nodes[b].right].box);
+
+		_nodes[a].height = 1 + std::max(_nodes[c].height, _nodes[_nodes[a].left].height);
+		_nodes[b].height = 1 + std::max(_nodes[a].height, _nodes[_nodes[b].right].height);
+
+		return b;
+	}
+
+	return a;
+}
+
+void AABBTree::collectLeaves(i32 node, Array<u32> &result) const {
+
+	// Whole subtree is inside, no more plane tests needed
+	size_t base = _stack.size();
+	_stack.push_back(node);
+
+	while (_stack.size() > base) {
+		i32 index = _stack.back();
+		_stack.pop_back();
+
+		if (_nodes[index].isLeaf()) {
+			result.push_back(_nodes[index].userData);
+		} else {
+			_stack.push_back(_nodes[index].left);
+			_stack.push_back(_nodes[index].right);
+		}
+	}
+}
+
+void AABBTree::query(const Frustum &frustum, Array<u32> &result) const {
+
+	if (_root == NullNode) return;
+
+	_stack.clear();
+	_stack.push_back(_root);
+
+	while (!_stack.empty()) {
+		i32 index = _stack.back();
+		_stack.pop_back();
+
+		Frustum::Result test = frustum.test(_nodes[index].box);
+		if (test == Frustum::Outside) continue;
+
+		if (test == Frustum::Inside) {
+			collectLeaves(index, result);
+		} else if (_nodes[index].isLeaf()) {
+			result.push_back(_nodes[index].userData);
+		} else {
+			_stack.push_back(_nodes[index].left);
+			_stack.push_back(_nodes[index].right);
+		}
+	}
+}
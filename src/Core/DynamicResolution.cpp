@@ -0,0 +1,70 @@
+#include <Core/DynamicResolution.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace NoxEngine;
+
+DynamicResolution::DynamicResolution() :
+	_settings(),
+	_enabled(false),
+	_scale(1.0f),
+	_sampleSum(0.0),
+	_sampleCount(0),
+	_framesSinceChange(0),
+	_averageMs(0.0)
+{
+}
+
+void DynamicResolution::setEnabled(bool enabled) {
+	_enabled = enabled;
+	_scale = quantize(_settings.maxScale);
+	_sampleSum = 0.0;
+	_sampleCount = 0;
+	_framesSinceChange = 0;
+}
+
+f32 DynamicResolution::quantize(f32 scale) const {
+	f32 maxScale = std::min(_settings.maxScale, 1.0f);
+	f32 minScale = std::min(_settings.minScale, maxScale);
+
+	scale = std::floor(scale / _settings.step + 0.001f) * _settings.step;
+	return std::clamp(scale, minScale, maxScale);
+}
+
+f32 DynamicResolution::update(f64 frameMs) {
+
+	if (!_enabled) return 1.0f;
+
+	_framesSinceChange++;
+	_sampleSum += frameMs;
+	_sampleCount++;
+
+	if (_sampleCount < _settings.sampleFrames) return _scale;
+
+	_averageMs = _sampleSum / _sampleCount;
+	_sampleSum = 0.0;
+	_sampleCount = 0;
+
+	// Timings from before the last change are still coming in
+	if (_framesSinceChange < _settings.cooldownFrames || _averageMs <= 0.0) return _scale;
+
+	f32 scale = _scale;
+
+	if (_averageMs > _settings.targetMs * (1.0 + _settings.headroom)) {
+		// Down to the scale whose pixel count should fit the target, at least one step
+		f32 fitting = _scale * (f32)std::sqrt(_settings.targetMs / _averageMs);
+		scale = quantize(std::min(fitting, _scale - _settings.step));
+	} else {
+		f32 larger = quantize(_scale + _settings.step);
+		f64 predictedMs = _averageMs * (larger * larger) / (_scale * _scale);
+		if (predictedMs < _settings.targetMs * (1.0 - _settings.headroom)) scale = larger;
+	}
+
+	if (scale != _scale) {
+		_scale = scale;
+		_framesSinceChange = 0;
+	}
+
+	return _scale;
+}
@@ -0,0 +1,113 @@
+#include <Core/FramePipeline.h>
+
+#include <algorithm>
+
+using namespace NoxEngine;
+
+FramePipeline::FramePipeline() :
+	_mutex(),
+	_finished(),
+	_running(false),
+	_packets(),
+	_front(0),
+	_backReady(false),
+	_frontInline(false),
+	_pipelined(true),
+	_frame(0),
+	_simulationStart(),
+	_simulationEnd(),
+	_renderStart(),
+	_renderEnd(),
+	_stats(),
+	_worker(1)
+{
+}
+
+FramePipeline::~FramePipeline() {
+	// The job points into the game state, it can't outlive it
+	blockUntilIdle();
+}
+
+void FramePipeline::waitForSimulation() {
+
+	Clock::time_point waitStart = Clock::now();
+	blockUntilIdle();
+	_stats.waitMs = std::chrono::duration<f64, std::milli>(Clock::now() - waitStart).count();
+}
+
+void FramePipeline::blockUntilIdle() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_finished.wait(lock, [this]() { return !_running; });
+}
+
+const RenderPacket& FramePipeline::launchSimulation(const SimulationJob &job) {
+
+	blockUntilIdle();
+	updateStats();
+
+	bool simulatedInline = false;
+
+	if (_backReady) {
+		_front = 1 - _front;
+	} else if (!_pipelined || !_frontInline) {
+		// First frame or pipelining off, nothing was simulated ahead so this frame's packet is simulated right here.
+		// Starting the next one as well would be a second step with this frame's delta, the next launch does it
+		simulate(job, _packets[1 - _front]);
+		_front = 1 - _front;
+		simulatedInline = true;
+	}
+	// Otherwise pipelining was just turned on after an inline frame, its packet is drawn once more while the
+	// simulation starts ahead, so every launch still advances the world by one step
+
+	_backReady = false;
+	_frontInline = simulatedInline;
+
+	if (_pipelined && !simulatedInline) {
+		RenderPacket *back = &_packets[1 - _front];
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_running = true;
+		}
+
+		_worker.submit([this, job, back]() {
+			simulate(job, *back);
+
+			std::lock_guard<std::mutex> lock(_mutex);
+			_running = false;
+			_finished.notify_one();
+		});
+
+		_backReady = true;
+	}
+
+	_renderStart = Clock::now();
+
+	return _packets[_front];
+}
+
+void FramePipeline::endFrame() {
+	_renderEnd = Clock::now();
+}
+
+void FramePipeline::simulate(const SimulationJob &job, RenderPacket &packet) {
+	_simulationStart = Clock::now();
+
+	packet.frame = _frame++;
+	job(packet);
+
+	_simulationEnd = Clock::now();
+}
+
+void FramePipeline::updateStats() {
+
+	// The last simulation and the last render span, serial frames never overlap since the simulation ends before the render starts
+	auto ms = [](Clock::duration d) { return std::chrono::duration<f64, std::milli>(d).count(); };
+
+	Clock::time_point overlapStart = std::max(_simulationStart, _renderStart);
+	Clock::time_point overlapEnd = std::min(_simulationEnd, _renderEnd);
+
+	_stats.simulationMs = ms(_simulationEnd - _simulationStart);
+	_stats.renderMs = ms(_renderEnd - _renderStart);
+	_stats.overlapMs = overlapEnd > overlapStart ? ms(overlapEnd - overlapStart) : 0.0;
+}
@@ -1,17 +1,72 @@
 #include <glad/glad.h>
 #include <Core/GLProgram.h>
+#include <Core/GLStateCache.h>
+#include <Core/ProgramBinaryCache.h>
 #include <Managers/IOManager.h>
 #include <Utils/MemAllocator.h>
 #include <assert.h>
+#include <cstring>
 
 using namespace NoxEngine;
 
+// Deeper than this is taken to be an include cycle
+static const u32 MaxIncludeDepth = 8;
+
+/*
+ * Reads a shader with every #include "file" line replaced by that file, looked up next to the including one.
+ * GLSL has no includes of its own, this lets blocks every stage has to declare identically live in one file.
+ * A #line after each include keeps compile errors pointing at the right line of the including file.
+ * */
+static bool readShaderSource(const String &filename, String &source, u32 depth = 0) {
+
+	if(depth > MaxIncludeDepth) {
+		LOG_DEBUG("Shader includes nested too deep at %s", filename.c_str());
+		return false;
+	}
+
+	String text;
+	{
+		TempResourceData temp = IOManager::Instance()->ReadEntireFileTemp(filename);
+		if(temp.data == nullptr) return false;
+		text.assign((const char*)temp.data, strnlen((const char*)temp.data, temp.size));
+	}
+
+	String directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+
+	u32 lineNumber = 1;
+	size_t lineStart = 0;
+	while(lineStart < text.size()) {
+		size_t lineEnd = text.find('\n', lineStart);
+		lineEnd = lineEnd == String::npos ? text.size() : lineEnd + 1;
+
+		size_t directive = text.find_first_not_of(" \t", lineStart);
+		size_t open = text.find('"', lineStart);
+		size_t close = open < lineEnd ? text.find('"', open + 1) : String::npos;
+
+		if(directive < lineEnd && text.compare(directive, 8, "#include") == 0 && close < lineEnd) {
+			String included = directory + text.substr(open + 1, close - open - 1);
+			if(!readShaderSource(included, source, depth + 1)) {
+				LOG_DEBUG("Can't include %s in %s", included.c_str(), filename.c_str());
+				return false;
+			}
+			source += "\n#line " + std::to_string(lineNumber + 1) + "\n";
+		} else {
+			source.append(text, lineStart, lineEnd - lineStart);
+		}
+
+		lineStart = lineEnd;
+		lineNumber++;
+	}
+
+	return true;
+}
+
 u32 GLProgram::compileShader(String& filename, i32 shaderType) {
 
-	TempResourceData temp = IOManager::Instance()->ReadEntireFileTemp(filename);
-	const char *data = (const char*)temp.data;
+	String source;
+	if(!readShaderSource(filename, source)) return 0;
 
-	if(data == nullptr) return 0;
+	const char *data = source.c_str();
 
 	u32 id = glCreateShader(shaderType);
 
@@ -61,80 +116,150 @@ GLuint GLProgram::compileShaderFromString(std::string shaderData, GLenum shaderT
 }
 
 
-u32 GLProgram::makeProgram(Array<ShaderFile> shaders) {
-	u32 id = glCreateProgram();
+GLProgram::GLProgram(Array<ShaderFile> shaders) :
+	_id(0),
+	_pending(false),
+	_binaryKey(0),
+	_shaders(),
+	_uniformLocations()
+{
+	ProgramBinaryCache *cache = ProgramBinaryCache::Instance();
+
+	Array<String> sources(shaders.size());
+	Array<u32> shaderTypes(shaders.size());
+
+	// Keyed on the sources with their includes, editing an included file rebuilds the program
 	for(i32 i = 0; i < shaders.size(); i++) {
-		if(shaders[i].id == 0) continue;
-		glAttachShader(id, shaders[i].id);
+		if(!readShaderSource(shaders[i].filename, sources[i])) sources[i].clear();
+		shaderTypes[i] = shaders[i].shader_type;
 	}
 
+	_id = glCreateProgram();
+	_binaryKey = cache->makeKey(sources, shaderTypes);
 
-	glLinkProgram(id);
+	if(cache->load(_binaryKey, _id)) {
+		_shaders = shaders;
+		return;
+	}
+
+	// Issue everything without querying status, a query would make the driver finish the work right away
+	for(i32 i = 0; i < shaders.size(); i++) {
+		if(sources[i].empty()) continue;
+
+		const char *data = sources[i].c_str();
+		shaders[i].id = glCreateShader(shaders[i].shader_type);
+		glShaderSource(shaders[i].id, 1, &data, NULL);
+		glCompileShader(shaders[i].id);
+		glAttachShader(_id, shaders[i].id);
+	}
+
+	glProgramParameteri(_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(_id);
+
+	_shaders = shaders;
+	_pending = true;
+
+	// Without the extension the calls above already did the work, nothing to gain by waiting
+	if(!cache->hasParallelCompile()) finishLink();
+}
+
+void GLProgram::finishLink() {
+
+	if(!_pending) return;
+	_pending = false;
+
+	for(i32 i = 0; i < _shaders.size(); i++) {
+		if(_shaders[i].id == 0) continue;
+
+		i32 result = GL_FALSE;
+		glGetShaderiv(_shaders[i].id, GL_COMPILE_STATUS, &result);
+
+		if (result != GL_TRUE) {
+			i32 infoLogLength;
+			glGetShaderiv(_shaders[i].id, GL_INFO_LOG_LENGTH, &infoLogLength);
+			char *temp_buf = (char*)StackMemAllocator::Instance()->allocate(infoLogLength);
+			glGetShaderInfoLog(_shaders[i].id, infoLogLength, NULL, temp_buf);
+			LOG_DEBUG("Error Compiling Shader %s: \n%s", _shaders[i].filename.c_str(), temp_buf);
+			StackMemAllocator::Instance()->free((u8*)temp_buf);
+		}
+	}
 
 	// Check the program
 	i32 result;
 	i32 length; 
-	glGetProgramiv(id, GL_LINK_STATUS, &result);
+	glGetProgramiv(_id, GL_LINK_STATUS, &result);
 	if (result != GL_TRUE) {
-		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
+		glGetProgramiv(_id, GL_INFO_LOG_LENGTH, &length);
 		char *buffer = (char*)StackMemAllocator::Instance()->allocate(length);
-		glGetProgramInfoLog(id, length, NULL, buffer);
+		glGetProgramInfoLog(_id, length, NULL, buffer);
 		LOG_DEBUG("Error Linking program: \n%s", buffer);
 		StackMemAllocator::Instance()->free((u8*)buffer);
+		return;
 	}
 
-	return id;
+	ProgramBinaryCache::Instance()->store(_binaryKey, _id);
 }
 
-GLProgram::GLProgram(Array<ShaderFile> shaders)
-{
-	for(i32 i = 0; i < shaders.size(); i++) {
-		shaders[i].id = compileShader(shaders[i].filename, shaders[i].shader_type);
-	}
+bool GLProgram::isReady() const {
 
-	_id = makeProgram(shaders);
-	_shaders = shaders;
+	if(!_pending) return true;
+
+	i32 done = GL_FALSE;
+	glGetProgramiv(_id, GL_COMPLETION_STATUS_KHR, &done);
+	return done == GL_TRUE;
 }
 
 void GLProgram::use()
 {
-	glUseProgram(_id);
+	finishLink();
+	GLStateCache::Instance()->useProgram(_id);
 }
 
 
 void GLProgram::setBool(const std::string& name, bool value) const
 {
-	glProgramUniform1i(_id, glGetUniformLocation(_id, name.c_str()), (int)value);
+	glProgramUniform1i(_id, getCachedUniformLocation(name), (int)value);
 }
 
 void GLProgram::setInt(const std::string& name, int value) const
 {
-	glProgramUniform1i(_id, glGetUniformLocation(_id, name.c_str()), value);
+	glProgramUniform1i(_id, getCachedUniformLocation(name), value);
 }
 
 void GLProgram::setFloat(const std::string& name, float value) const
 {
-	glProgramUniform1f(_id, glGetUniformLocation(_id, name.c_str()), value);
+	glProgramUniform1f(_id, getCachedUniformLocation(name), value);
 }
 
 void GLProgram::set3Float(const std::string& name, float x, float y, float z) const
 {
-    glProgramUniform3f(_id, glGetUniformLocation(_id, name.c_str()), x, y, z);
+    glProgramUniform3f(_id, getCachedUniformLocation(name), x, y, z);
 }
 
 void GLProgram::set4Float(const std::string& name, float x, float y, float z, float w) const
 {
-	glProgramUniform4f(_id, glGetUniformLocation(_id, name.c_str()), x, y, z, w);
+	glProgramUniform4f(_id, getCachedUniformLocation(name), x, y, z, w);
 }
 
 void GLProgram::set4Matrix(const std::string &name, glm::mat4 mat) const
 {
-  glProgramUniformMatrix4fv(_id, glGetUniformLocation(_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+  glProgramUniformMatrix4fv(_id, getCachedUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+i32 GLProgram::getCachedUniformLocation(const String& name) const
+{
+	auto itr = _uniformLocations.find(name);
+	if (itr != _uniformLocations.end()) return itr->second;
+
+	i32 location = glGetUniformLocation(_id, name.c_str());
+	_uniformLocations.emplace(name, location);
+
+	return location;
 }
 
 int GLProgram::getUniformLocation(const std::string& name)
 {
-	return glGetUniformLocation(_id, name.c_str());
+	return getCachedUniformLocation(name);
 }
 
 int GLProgram::getAtrributeLocation(const std::string& name)
@@ -161,52 +286,3 @@ void GLProgram::printAttribInfo()
 	StackMemAllocator::Instance()->free((u8*)mem);
 	
 }
-
-void GLProgram::changeLightNum(i32 num_of_light)
-{
-	numOfLights = num_of_light;
-	for (u32 i = 0; i < _shaders.size(); i++)
-	{
-		// Read shader content
-		TempResourceData temp = IOManager::Instance()->ReadEntireFileTemp(_shaders[i].filename);
-		std::string shaderData = std::string((const char*)temp.data);
-
-		// Check if the shaders attached to this program have num_of_lights defined
-		size_t found = shaderData.find("#define NUM_OF_LIGHTS");
-
-		// If not -> assume that the shaders don't have multiple lights and escape
-		if (found == std::string::npos)
-		{
-			// TODO: find it/ask it LOG MESSAGE HERE
-			return;
-		}
-
-		// If has -> change the num of lights
-
-		std::string result;
-		result = "#version 450 core\n#define NUM_OF_LIGHTS " + std::to_string(num_of_light);
-		num_of_light;
-		result += "\n";
-
-		std::string restOf = shaderData.substr(found);
-		found = restOf.find("\n");
-		result += restOf.substr(found + 1);
-
-		// Create shaders
-		_shaders[i].id = compileShaderFromString(result, _shaders[i].shader_type);
-
-	}
-
-	// Make the program
-	GLuint newId = makeProgram(_shaders);
-
-	// Delete existing program
-	glDeleteProgram(_id);
-
-	// Store new one
-	_id = newId;
-
-	return;
-
-}
-
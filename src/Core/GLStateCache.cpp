@@ -0,0 +1,59 @@
+#include <Core/GLStateCache.h>
+
+using namespace NoxEngine;
+
+// Never a valid name, forces the next bind through
+static const GLuint kUnknown = ~0u;
+
+GLStateCache::GLStateCache() :
+	_frame(),
+	_lastFrame()
+{
+	invalidate();
+}
+
+bool GLStateCache::track(GLuint &current, GLuint value) {
+	if (current == value) {
+		_frame.bindsSkipped++;
+		return false;
+	}
+
+	current = value;
+	_frame.bindsIssued++;
+	return true;
+}
+
+void GLStateCache::useProgram(GLuint program) {
+	if (track(_program, program)) glUseProgram(program);
+}
+
+void GLStateCache::bindFramebuffer(GLuint framebuffer) {
+	if (track(_framebuffer, framebuffer)) glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLStateCache::bindVertexArray(GLuint vertexArray) {
+	if (track(_vertexArray, vertexArray)) glBindVertexArray(vertexArray);
+}
+
+void GLStateCache::bindTexture(u32 unit, GLuint texture) {
+	if (unit >= MaxTextureUnits) {
+		glBindTextureUnit(unit, texture);
+		_frame.bindsIssued++;
+		return;
+	}
+
+	if (track(_textures[unit], texture)) glBindTextureUnit(unit, texture);
+}
+
+void GLStateCache::invalidate() {
+	_program = kUnknown;
+	_framebuffer = kUnknown;
+	_vertexArray = kUnknown;
+	for (u32 i = 0; i < MaxTextureUnits; i++) _textures[i] = kUnknown;
+}
+
+void GLStateCache::beginFrame() {
+	_lastFrame = _frame;
+	_frame = {};
+	invalidate();
+}
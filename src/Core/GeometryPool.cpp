@@ -0,0 +1,152 @@
+#include <Core/GeometryPool.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+
+using namespace NoxEngine;
+
+// Insert a free range keeping the list sorted, merging it with touching neighbours
+static void insertFreeRange(Array<PoolRange> &freeRanges, PoolRange range) {
+
+	auto itr = std::lower_bound(freeRanges.begin(), freeRanges.end(), range,
+			[](const PoolRange &a, const PoolRange &b) { return a.offset < b.offset; });
+
+	itr = freeRanges.insert(itr, range);
+
+	auto next = itr + 1;
+	if (next != freeRanges.end() && itr->offset + itr->count == next->offset) {
+		itr->count += next->count;
+		freeRanges.erase(next);
+	}
+
+	if (itr != freeRanges.begin()) {
+		auto prev = itr - 1;
+		if (prev->offset + prev->count == itr->offset) {
+			prev->count += itr->count;
+			freeRanges.erase(itr);
+		}
+	}
+}
+
+RangeAllocator::RangeAllocator(u32 capacity) :
+	_free(),
+	_capacity(capacity),
+	_used(0)
+{
+	if (capacity > 0) _free.push_back({ 0, capacity });
+}
+
+bool RangeAllocator::allocate(u32 count, PoolRange &range) {
+
+	if (count == 0) {
+		range = { 0, 0 };
+		return true;
+	}
+
+	for (u32 i = 0; i < _free.size(); i++) {
+		if (_free[i].count < count) continue;
+
+		range = { _free[i].offset, count };
+
+		_free[i].offset += count;
+		_free[i].count -= count;
+		if (_free[i].count == 0) _free.erase(_free.begin() + i);
+
+		_used += count;
+		return true;
+	}
+
+	return false;
+}
+
+void RangeAllocator::release(PoolRange range) {
+	if (range.count == 0) return;
+
+	insertFreeRange(_free, range);
+	_used -= range.count;
+}
+
+void RangeAllocator::grow(u32 newCapacity) {
+	if (newCapacity <= _capacity) return;
+
+	insertFreeRange(_free, { _capacity, newCapacity - _capacity });
+	_capacity = newCapacity;
+}
+
+void RangeAllocator::reset() {
+	_free.clear();
+	if (_capacity > 0) _free.push_back({ 0, _capacity });
+	_used = 0;
+}
+
+u32 RangeAllocator::getLargestFree() const {
+	u32 largest = 0;
+	for (const PoolRange &range : _free) largest = std::max(largest, range.count);
+	return largest;
+}
+
+
+GeometryPool::GeometryPool(u32 initialCapacity, const Array<u32> &strides) :
+	_ranges(initialCapacity),
+	_strides(strides),
+	_buffers(strides.size(), 0)
+{
+	glCreateBuffers((GLsizei)_buffers.size(), _buffers.data());
+
+	for (u32 i = 0; i < _buffers.size(); i++) {
+		glNamedBufferData(_buffers[i], (GLsizeiptr)initialCapacity * _strides[i], NULL, GL_DYNAMIC_DRAW);
+	}
+}
+
+GeometryPool::~GeometryPool() {
+	glDeleteBuffers((GLsizei)_buffers.size(), _buffers.data());
+}
+
+bool GeometryPool::allocate(u32 count, PoolRange &range) {
+
+	if (_ranges.allocate(count, range)) return false;
+
+	grow(_ranges.getCapacity() + count);
+	_ranges.allocate(count, range);
+
+	return true;
+}
+
+void GeometryPool::release(PoolRange range) {
+	_ranges.release(range);
+}
+
+void GeometryPool::reset() {
+	_ranges.reset();
+}
+
+void GeometryPool::upload(u32 bufferIndex, PoolRange range, const void *data) {
+	if (range.count == 0 || data == nullptr) return;
+
+	u32 stride = _strides[bufferIndex];
+	glNamedBufferSubData(_buffers[bufferIndex], (GLintptr)range.offset * stride, (GLsizeiptr)range.count * stride, data);
+}
+
+void GeometryPool::grow(u32 minCapacity) {
+
+	u32 oldCapacity = _ranges.getCapacity();
+	u32 newCapacity = std::max(oldCapacity * 2, minCapacity);
+
+	for (u32 i = 0; i < _buffers.size(); i++) {
+
+		GLuint newBuffer;
+		glCreateBuffers(1, &newBuffer);
+		glNamedBufferData(newBuffer, (GLsizeiptr)newCapacity * _strides[i], NULL, GL_DYNAMIC_DRAW);
+
+		if (oldCapacity > 0) {
+			glCopyNamedBufferSubData(_buffers[i], newBuffer, 0, 0, (GLsizeiptr)oldCapacity * _strides[i]);
+		}
+
+		glDeleteBuffers(1, &_buffers[i]);
+		_buffers[i] = newBuffer;
+	}
+
+	_ranges.grow(newCapacity);
+
+	LOG_DEBUG("Geometry pool grown from %u to %u elements", oldCapacity, newCapacity);
+}
@@ -0,0 +1,158 @@
+#include <Core/GpuProfiler.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+using namespace NoxEngine;
+
+GpuProfiler::GpuProfiler() :
+	_frames(),
+	_frame(0),
+	_openScopes(),
+	_timers(),
+	_droppedFrames(0),
+	_frameMs(0.0),
+	_enabled(true)
+{
+}
+
+void GpuProfiler::beginFrame() {
+
+	// Scopes the last frame left open can't be closed in this one
+	_openScopes.clear();
+
+	_frame++;
+	FrameQueries &frame = _frames[_frame % FrameLatency];
+
+	collect(frame);
+
+	frame.scopes.clear();
+	frame.queriesUsed = 0;
+}
+
+void GpuProfiler::begin(const char *name) {
+
+	if (!_enabled) return;
+
+	FrameQueries &frame = _frames[_frame % FrameLatency];
+
+	Scope scope = { findTimer(name, (u32)_openScopes.size()), nextQuery(), 0 };
+	glQueryCounter(scope.startQuery, GL_TIMESTAMP);
+
+	_openScopes.push_back((u32)frame.scopes.size());
+	frame.scopes.push_back(scope);
+}
+
+void GpuProfiler::end() {
+
+	if (_openScopes.empty()) return;
+
+	FrameQueries &frame = _frames[_frame % FrameLatency];
+
+	Scope &scope = frame.scopes[_openScopes.back()];
+	_openScopes.pop_back();
+
+	scope.endQuery = nextQuery();
+	glQueryCounter(scope.endQuery, GL_TIMESTAMP);
+}
+
+GLuint GpuProfiler::nextQuery() {
+
+	FrameQueries &frame = _frames[_frame % FrameLatency];
+
+	if (frame.queriesUsed == frame.queries.size()) {
+		GLuint query;
+		glCreateQueries(GL_TIMESTAMP, 1, &query);
+		frame.queries.push_back(query);
+	}
+
+	return frame.queries[frame.queriesUsed++];
+}
+
+u32 GpuProfiler::findTimer(const char *name, u32 depth) {
+
+	for (u32 i = 0; i < _timers.size(); i++) {
+		if (_timers[i].depth == depth && strcmp(_timers[i].name.c_str(), name) == 0) return i;
+	}
+
+	GpuTimer timer = {};
+	timer.name = name;
+	timer.depth = depth;
+	_timers.push_back(timer);
+
+	return (u32)_timers.size() - 1;
+}
+
+void GpuProfiler::collect(FrameQueries &frame) {
+
+	if (frame.scopes.empty()) return;
+
+	// Queries complete in order, once the last one is available all of them are
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(frame.queries[frame.queriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available != GL_TRUE) {
+		_droppedFrames++;
+		return;
+	}
+
+	// A timer can run more than once a frame, its sample is the sum
+	Array<f64> frameMs(_timers.size(), -1.0);
+	_frameMs = 0.0;
+
+	for (const Scope &scope : frame.scopes) {
+		if (scope.endQuery == 0) continue;
+
+		GLuint64 start = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(scope.startQuery, GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &end);
+
+		f64 scopeMs = (end - start) / 1000000.0;
+		f64 &total = frameMs[scope.timer];
+		total = std::max(total, 0.0) + scopeMs;
+
+		if (_timers[scope.timer].depth == 0) _frameMs += scopeMs;
+	}
+
+	for (u32 i = 0; i < _timers.size(); i++) {
+		if (frameMs[i] < 0.0) continue;
+
+		GpuTimer &timer = _timers[i];
+		timer.lastMs = frameMs[i];
+		timer.history[timer.historyNext] = frameMs[i];
+		timer.historyNext = (timer.historyNext + 1) % GpuTimer::HistorySize;
+		timer.historyCount = std::min(timer.historyCount + 1, GpuTimer::HistorySize);
+
+		f64 sum = 0.0;
+		timer.minMs = timer.history[0];
+		timer.maxMs = timer.history[0];
+		for (u32 j = 0; j < timer.historyCount; j++) {
+			sum += timer.history[j];
+			timer.minMs = std::min(timer.minMs, timer.history[j]);
+			timer.maxMs = std::max(timer.maxMs, timer.history[j]);
+		}
+		timer.averageMs = sum / timer.historyCount;
+	}
+}
+
+bool GpuProfiler::writeCsv(const String &path) const {
+
+	std::ofstream output(path);
+	if (!output) {
+		LOG_DEBUG("Can't open %s for the GPU timings", path.c_str());
+		return false;
+	}
+
+	output << "name,depth,last_ms,average_ms,min_ms,max_ms,samples\n";
+
+	for (const GpuTimer &timer : _timers) {
+		output << '"' << timer.name << "\"," << timer.depth << ',' << timer.lastMs << ',' << timer.averageMs << ','
+			<< timer.minMs << ',' << timer.maxMs << ',' << timer.historyCount << '\n';
+	}
+
+	LOG_DEBUG("GPU timings written to %s", path.c_str());
+
+	return true;
+}
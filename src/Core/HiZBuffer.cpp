@@ -0,0 +1,223 @@
+#include <Core/HiZBuffer.h>
+#include <Core/GLStateCache.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace NoxEngine;
+
+HiZBuffer::HiZBuffer() :
+	_downsample(nullptr),
+	_pyramid(0),
+	_pyramidWidth(0),
+	_pyramidHeight(0),
+	_pyramidLevels(0),
+	_readbacks(),
+	_nextReadback(0),
+	_levels(),
+	_firstShift(0),
+	_screenWidth(0),
+	_screenHeight(0),
+	_viewProjection(1.0f)
+{
+	_downsample = new GLProgram(Array<ShaderFile>{
+		{ "assets/shaders/hizDownsample.comp", GL_COMPUTE_SHADER, 0 },
+	});
+
+	for (Readback &slot : _readbacks) {
+		slot = {};
+		glCreateBuffers(1, &slot.buffer);
+	}
+}
+
+HiZBuffer::~HiZBuffer() {
+	clear();
+
+	for (Readback &slot : _readbacks) glDeleteBuffers(1, &slot.buffer);
+	glDeleteTextures(1, &_pyramid);
+	delete _downsample;
+}
+
+void HiZBuffer::clear() {
+	for (Readback &slot : _readbacks) {
+		if (slot.fence != nullptr) glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+
+	_levels.clear();
+}
+
+void HiZBuffer::allocate(u32 width, u32 height) {
+
+	// Read backs in flight were sized for the old pyramid
+	clear();
+	glDeleteTextures(1, &_pyramid);
+
+	// Levels halve down to the read back size. Padding the first one to a multiple of the last keeps every
+	// level exactly half the one above, texel (x, y) of level i then covers pixels (x, y) << (i + 1) onwards
+	_pyramidLevels = 1;
+	while ((width + (1u << _pyramidLevels) - 1) >> _pyramidLevels > ReadbackWidth) _pyramidLevels++;
+
+	u32 readbackWidth = (width + (1u << _pyramidLevels) - 1) >> _pyramidLevels;
+	u32 readbackHeight = (height + (1u << _pyramidLevels) - 1) >> _pyramidLevels;
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &_pyramid);
+	glTextureStorage2D(_pyramid, _pyramidLevels, GL_R32F,
+			readbackWidth << (_pyramidLevels - 1), readbackHeight << (_pyramidLevels - 1));
+
+	for (Readback &slot : _readbacks) {
+		glNamedBufferData(slot.buffer, readbackWidth * readbackHeight * sizeof(f32), NULL, GL_STREAM_READ);
+	}
+
+	_pyramidWidth = width;
+	_pyramidHeight = height;
+}
+
+void HiZBuffer::build(GLuint depthTexture, u32 width, u32 height, const mat4 &viewProjection) {
+
+	if (width != _pyramidWidth || height != _pyramidHeight) allocate(width, height);
+
+	// Every slot is still waiting on the GPU, this frame's depth is skipped
+	Readback &slot = _readbacks[_nextReadback];
+	if (slot.fence != nullptr) return;
+
+	_downsample->use();
+	GLStateCache *state = GLStateCache::Instance();
+
+	u32 readbackWidth = (width + (1u << _pyramidLevels) - 1) >> _pyramidLevels;
+	u32 readbackHeight = (height + (1u << _pyramidLevels) - 1) >> _pyramidLevels;
+
+	for (u32 level = 0; level < _pyramidLevels; level++) {
+		u32 levelWidth = readbackWidth << (_pyramidLevels - 1 - level);
+		u32 levelHeight = readbackHeight << (_pyramidLevels - 1 - level);
+
+		state->bindTexture(0, level == 0 ? depthTexture : _pyramid);
+		_downsample->setInt("sourceLevel", level == 0 ? 0 : level - 1);
+		glBindImageTexture(0, _pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute((levelWidth + 7) / 8, (levelHeight + 7) / 8, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+	}
+
+	// The copy into the pixel buffer is queued like a draw, the fence says when the CPU can have it
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glGetTextureImage(_pyramid, _pyramidLevels - 1, GL_RED, GL_FLOAT, readbackWidth * readbackHeight * sizeof(f32), nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.width = readbackWidth;
+	slot.height = readbackHeight;
+	slot.shift = _pyramidLevels;
+	slot.screenWidth = width;
+	slot.screenHeight = height;
+	slot.viewProjection = viewProjection;
+
+	_nextReadback = (_nextReadback + 1) % ReadbackSlots;
+}
+
+void HiZBuffer::collect() {
+
+	// Oldest first, once one isn't done the later ones aren't either. Only the newest done one is kept
+	Readback *newest = nullptr;
+	for (u32 i = 0; i < ReadbackSlots; i++) {
+		Readback &slot = _readbacks[(_nextReadback + i) % ReadbackSlots];
+		if (slot.fence == nullptr) continue;
+
+		GLenum status = glClientWaitSync(slot.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		newest = &slot;
+	}
+
+	if (newest == nullptr) return;
+
+	_firstShift = newest->shift;
+	_screenWidth = newest->screenWidth;
+	_screenHeight = newest->screenHeight;
+	_viewProjection = newest->viewProjection;
+
+	_levels.resize(1);
+	_levels[0].width = newest->width;
+	_levels[0].height = newest->height;
+	_levels[0].depths.resize(newest->width * newest->height);
+	glGetNamedBufferSubData(newest->buffer, 0, _levels[0].depths.size() * sizeof(f32), _levels[0].depths.data());
+
+	// The rest of the pyramid is small enough to finish here, same reduction as the compute shader
+	while (_levels.back().width > 1 || _levels.back().height > 1) {
+		_levels.emplace_back();
+		const Level &source = _levels[_levels.size() - 2];
+		Level &level = _levels.back();
+
+		level.width = (source.width + 1) / 2;
+		level.height = (source.height + 1) / 2;
+		level.depths.resize(level.width * level.height);
+
+		for (u32 y = 0; y < level.height; y++) {
+			u32 y0 = y * 2;
+			u32 y1 = std::min(y0 + 1, source.height - 1);
+
+			for (u32 x = 0; x < level.width; x++) {
+				u32 x0 = x * 2;
+				u32 x1 = std::min(x0 + 1, source.width - 1);
+
+				level.depths[y * level.width + x] = std::max(
+						std::max(source.depths[y0 * source.width + x0], source.depths[y0 * source.width + x1]),
+						std::max(source.depths[y1 * source.width + x0], source.depths[y1 * source.width + x1]));
+			}
+		}
+	}
+}
+
+bool HiZBuffer::isOccluded(const AABB &bounds) const {
+
+	if (_levels.empty()) return false;
+
+	vec2 minNdc(1.0f);
+	vec2 maxNdc(-1.0f);
+	f32 nearest = 1.0f;
+
+	for (u32 i = 0; i < 8; i++) {
+		vec3 corner((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z);
+		vec4 clip = _viewProjection * vec4(corner, 1.0f);
+
+		// In front of the near plane, the projection of the box isn't bounded
+		if (clip.z < -clip.w) return false;
+
+		vec3 ndc = vec3(clip) / clip.w;
+		minNdc = glm::min(minNdc, vec2(ndc));
+		maxNdc = glm::max(maxNdc, vec2(ndc));
+		nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+	}
+
+	// Off the screen the pyramid was drawn for, the frustum test of this frame decides
+	if (maxNdc.x < -1.0f || maxNdc.y < -1.0f || minNdc.x > 1.0f || minNdc.y > 1.0f) return false;
+
+	vec2 screen((f32)_screenWidth, (f32)_screenHeight);
+	vec2 minPixel = glm::clamp((minNdc * 0.5f + 0.5f) * screen, vec2(0.0f), screen - 1.0f);
+	vec2 maxPixel = glm::clamp((maxNdc * 0.5f + 0.5f) * screen, vec2(0.0f), screen - 1.0f);
+
+	u32 x0 = (u32)minPixel.x, y0 = (u32)minPixel.y;
+	u32 x1 = (u32)maxPixel.x, y1 = (u32)maxPixel.y;
+
+	// Coarsest level needed for the rectangle to span at most 2x2 texels
+	u32 levelIndex = 0;
+	while (levelIndex + 1 < _levels.size()) {
+		u32 shift = _firstShift + levelIndex;
+		if ((x1 >> shift) - (x0 >> shift) <= 1 && (y1 >> shift) - (y0 >> shift) <= 1) break;
+		levelIndex++;
+	}
+
+	const Level &level = _levels[levelIndex];
+	u32 shift = _firstShift + levelIndex;
+
+	f32 farthest = 0.0f;
+	for (u32 y = y0 >> shift; y <= std::min(y1 >> shift, level.height - 1); y++) {
+		for (u32 x = x0 >> shift; x <= std::min(x1 >> shift, level.width - 1); x++) {
+			farthest = std::max(farthest, level.depths[y * level.width + x]);
+		}
+	}
+
+	return nearest > farthest;
+}
@@ -0,0 +1,133 @@
+#include <Core/LightClusters.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace NoxEngine;
+
+LightClusters::LightClusters() :
+	_viewX(), _viewY(), _viewZ(), _radius(),
+	_minX(), _maxX(), _minY(), _maxY(), _minZ(), _maxZ(),
+	_ranges(ClusterCount * 2, 0),
+	_indices(),
+	_rangeSlice(),
+	_indexSlice(),
+	_depthParams(0.0f),
+	_binningMs(0.0)
+{
+}
+
+LightClusters::~LightClusters() {
+}
+
+// Float to cluster coordinate, clamped before the cast so far away lights can't overflow it
+static inline i32 toCluster(f32 value, u32 gridSize) {
+	return (i32)std::floor(std::clamp(value, -1.0f, (f32)gridSize));
+}
+
+void LightClusters::build(const Array<LightUniforms> &lights, const mat4 &view, const mat4 &projection) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Planes back from a glm::perspective matrix, so the grid always matches the projection in use
+	f32 nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+	f32 farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+
+	f32 logRange = std::log(farPlane / nearPlane);
+	f32 sliceScale = GridZ / logRange;
+	f32 sliceBias = -(f32)GridZ * std::log(nearPlane) / logRange;
+	_depthParams = vec4(sliceScale, sliceBias, nearPlane, farPlane);
+
+	f32 projX = projection[0][0];
+	f32 projY = projection[1][1];
+
+	u32 count = (u32)lights.size();
+
+	_viewX.resize(count); _viewY.resize(count); _viewZ.resize(count); _radius.resize(count);
+	_minX.resize(count); _maxX.resize(count);
+	_minY.resize(count); _maxY.resize(count);
+	_minZ.resize(count); _maxZ.resize(count);
+
+	for (u32 i = 0; i < count; i++) {
+		const vec4 &p = lights[i].position;
+		_viewX[i] = view[0][0] * p.x + view[1][0] * p.y + view[2][0] * p.z + view[3][0];
+		_viewY[i] = view[0][1] * p.x + view[1][1] * p.y + view[2][1] * p.z + view[3][1];
+		_viewZ[i] = view[0][2] * p.x + view[1][2] * p.y + view[2][2] * p.z + view[3][2];
+		// No range reaches everywhere, infinity clamps to the whole grid below
+		_radius[i] = p.w > 0.0f ? p.w : std::numeric_limits<f32>::infinity();
+	}
+
+	// Cluster bounds of every light's sphere. No branches, lights outside the frustum get an empty z range
+	for (u32 i = 0; i < count; i++) {
+		f32 r = _radius[i];
+		f32 depth = -_viewZ[i];
+
+		f32 closest = std::max(depth - r, nearPlane);
+		f32 furthest = std::clamp(depth + r, nearPlane, farPlane);
+
+		// x / depth is monotonic in depth, so the box corners at both depths bound the projection
+		f32 left = _viewX[i] - r, right = _viewX[i] + r;
+		f32 bottom = _viewY[i] - r, top = _viewY[i] + r;
+
+		f32 ndcMinX = std::min(left / closest, left / furthest) * projX;
+		f32 ndcMaxX = std::max(right / closest, right / furthest) * projX;
+		f32 ndcMinY = std::min(bottom / closest, bottom / furthest) * projY;
+		f32 ndcMaxY = std::max(top / closest, top / furthest) * projY;
+
+		_minX[i] = std::max(toCluster((ndcMinX * 0.5f + 0.5f) * GridX, GridX), 0);
+		_maxX[i] = std::min(toCluster((ndcMaxX * 0.5f + 0.5f) * GridX, GridX), (i32)GridX - 1);
+		_minY[i] = std::max(toCluster((ndcMinY * 0.5f + 0.5f) * GridY, GridY), 0);
+		_maxY[i] = std::min(toCluster((ndcMaxY * 0.5f + 0.5f) * GridY, GridY), (i32)GridY - 1);
+		_minZ[i] = std::max(toCluster(std::log(closest) * sliceScale + sliceBias, GridZ), 0);
+		_maxZ[i] = std::min(toCluster(std::log(furthest) * sliceScale + sliceBias, GridZ), (i32)GridZ - 1);
+
+		bool visible = depth + r > nearPlane && depth - r < farPlane;
+		_maxZ[i] = visible ? _maxZ[i] : -1;
+	}
+
+	// Count per cluster, prefix sum into offsets, then scatter the light indices
+	std::fill(_ranges.begin(), _ranges.end(), 0);
+
+	for (u32 i = 0; i < count; i++) {
+		for (i32 z = _minZ[i]; z <= _maxZ[i]; z++)
+		for (i32 y = _minY[i]; y <= _maxY[i]; y++)
+		for (i32 x = _minX[i]; x <= _maxX[i]; x++) {
+			_ranges[(x + GridX * (y + GridY * z)) * 2 + 1]++;
+		}
+	}
+
+	u32 offset = 0;
+	for (u32 c = 0; c < ClusterCount; c++) {
+		_ranges[c * 2] = offset;
+		offset += _ranges[c * 2 + 1];
+		_ranges[c * 2 + 1] = 0;
+	}
+
+	_indices.resize(offset);
+
+	for (u32 i = 0; i < count; i++) {
+		for (i32 z = _minZ[i]; z <= _maxZ[i]; z++)
+		for (i32 y = _minY[i]; y <= _maxY[i]; y++)
+		for (i32 x = _minX[i]; x <= _maxX[i]; x++) {
+			u32 *range = &_ranges[(x + GridX * (y + GridY * z)) * 2];
+			_indices[range[0] + range[1]++] = i;
+		}
+	}
+
+	_binningMs = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	StreamBuffer *stream = StreamBuffer::Instance();
+	_rangeSlice = stream->upload(_ranges.data(), (u32)_ranges.size() * sizeof(u32));
+
+	// Never empty, a zero sized range can't be bound
+	_indexSlice = stream->allocate(std::max((u32)_indices.size(), 1u) * sizeof(u32));
+	if (!_indices.empty()) memcpy(_indexSlice.data, _indices.data(), _indices.size() * sizeof(u32));
+}
+
+void LightClusters::bind(u32 rangeBinding, u32 indexBinding) {
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, rangeBinding, _rangeSlice.buffer, _rangeSlice.offset, _rangeSlice.size);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, indexBinding, _indexSlice.buffer, _indexSlice.offset, _indexSlice.size);
+}
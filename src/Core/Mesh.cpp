@@ -1,4 +1,5 @@
 #include <Core/Mesh.h>
+#include <Core/MeshSimplifier.h>
 #include <iostream>
 #include <glm/gtx/string_cast.hpp>
 
@@ -6,7 +7,7 @@
 using namespace NoxEngine;
 using NoxEngineUtils::Logger;
 
-Mesh::Mesh() : RenderableComponent()
+Mesh::Mesh() : RenderableComponent(), geometrySource(nullptr)
 {
 	glRenderType = GL_TRIANGLES;
 	has_normal = true;
@@ -14,7 +15,7 @@ Mesh::Mesh() : RenderableComponent()
 	use_indices = false;
 }
 
-Mesh::Mesh(const Mesh& other)
+Mesh::Mesh(const Mesh& other) : geometrySource(other.geometrySource)
 {
 	glRenderType = other.glRenderType;
 	has_normal = other.has_normal;
@@ -23,12 +24,23 @@ Mesh::Mesh(const Mesh& other)
 
 	name = other.name;
 	hasBones = other.hasBones;
-
-	vertices = other.vertices;
-	texCoords = other.texCoords;
-	normals = other.normals;
-	faces = other.faces;
-	indices = other.indices;
+	geometryKey = other.geometryKey;
+
+	if (geometrySource == nullptr) {
+		vertices = other.vertices;
+		texCoords = other.texCoords;
+		normals = other.normals;
+		faces = other.faces;
+		indices = other.indices;
+		lods = other.lods;
+	} else {
+		vertices.clear();
+		texCoords.clear();
+		normals.clear();
+		faces.clear();
+		indices.clear();
+		lods.clear();
+	}
 
 	color[0] = other.color[0];
 	color[1] = other.color[1];
@@ -39,7 +51,32 @@ Mesh::Mesh(const Mesh& other)
 	rendObjId = other.rendObjId;
 }
 
-Mesh::Mesh(std::istream& stream)
+Mesh::Mesh(const Mesh* source) : geometrySource(source)
+{
+	glRenderType = source->glRenderType;
+	has_normal = source->has_normal;
+	has_texture = source->has_texture;
+	use_indices = source->use_indices;
+
+	name = source->name;
+	hasBones = source->hasBones;
+	geometryKey = source->geometryKey;
+
+	// Drop the default cube of RenderableComponent, the arrays come from the source
+	vertices.clear();
+	texCoords.clear();
+	normals.clear();
+	faces.clear();
+	indices.clear();
+
+	color[0] = source->color[0];
+	color[1] = source->color[1];
+	color[2] = source->color[2];
+
+	rendObjId = -1;
+}
+
+Mesh::Mesh(std::istream& stream) : geometrySource(nullptr)
 {
 	size_t nameSize;
 	stream.read((char*)&nameSize, sizeof(nameSize));
@@ -79,10 +116,77 @@ Mesh::Mesh(std::istream& stream)
 	stream.read((char*)&indices[0], indicesSize * sizeof(i32));
 
 	stream.read((char*)&color[0], 3 * sizeof(f32));
+
+	buildLods();
 }
 
 Mesh::~Mesh() { }
 
+Array<i32> Mesh::triangleList() const {
+
+	if (use_indices) return indices;
+
+	Array<i32> triangles;
+	triangles.reserve(faces.size() * 3);
+	for (const ivec3 &face : faces) triangles.insert(triangles.end(), { face[0], face[1], face[2] });
+
+	return triangles;
+}
+
+void Mesh::setTriangleList(const Array<i32> &triangles) {
+
+	if (use_indices) {
+		indices = triangles;
+		return;
+	}
+
+	for (u32 i = 0; i < faces.size(); i++) faces[i] = ivec3(triangles[i * 3 + 0], triangles[i * 3 + 1], triangles[i * 3 + 2]);
+}
+
+// Moves every element of attribute to remap[index], arrays not sized per vertex are left alone
+template<typename T>
+static void remapAttribute(Array<T> &attribute, const Array<u32> &remap) {
+
+	if (attribute.size() != remap.size()) return;
+
+	Array<T> remapped(attribute.size());
+	for (u32 i = 0; i < attribute.size(); i++) remapped[remap[i]] = attribute[i];
+	attribute.swap(remapped);
+}
+
+VertexCacheStats Mesh::optimizeIndexOrder() {
+
+	VertexCacheStats stats = {};
+	if (geometrySource != nullptr || glRenderType != GL_TRIANGLES) return stats;
+
+	u32 vertexCount = (u32)vertices.size();
+	Array<i32> triangles = triangleList();
+
+	stats.triangles = (u32)triangles.size() / 3;
+	stats.acmrBefore = computeAcmr(triangles, vertexCount);
+
+	optimizeVertexCache(triangles, vertexCount);
+
+	Array<u32> remap;
+	optimizeVertexFetch(triangles, vertexCount, remap);
+	remapAttribute(vertices, remap);
+	remapAttribute(normals, remap);
+	remapAttribute(texCoords, remap);
+
+	stats.acmrAfter = computeAcmr(triangles, vertexCount);
+	setTriangleList(triangles);
+
+	return stats;
+}
+
+void Mesh::buildLods() {
+
+	lods.clear();
+	if (geometrySource != nullptr || glRenderType != GL_TRIANGLES) return;
+
+	generateLods(vertices, triangleList(), lods);
+}
+
 void Mesh::setTexture(const String filename)
 {
 	ambientTexture = filename;
@@ -102,26 +206,26 @@ void Mesh::serialize(std::ostream& stream)
 	stream.write((char*)&has_texture, sizeof(i8));
 	stream.write((char*)&use_indices, sizeof(i8));
 
-	size_t verticesSize = vertices.size();
+	size_t verticesSize = getVertices().size();
 	stream.write((char*)&verticesSize, sizeof(verticesSize));
-	stream.write((char*)&vertices[0], verticesSize * sizeof(vec3));
+	stream.write((const char*)getVertices().data(), verticesSize * sizeof(vec3));
 
-	size_t texCoordsSize = texCoords.size();
+	size_t texCoordsSize = getTexCoords().size();
 	stream.write((char*)&texCoordsSize, sizeof(texCoordsSize));
-	stream.write((char*)&texCoords[0], texCoordsSize * sizeof(vec2));
+	stream.write((const char*)getTexCoords().data(), texCoordsSize * sizeof(vec2));
 
-	size_t normalSize = normals.size();
+	size_t normalSize = getNormals().size();
 	stream.write((char*)&normalSize, sizeof(normalSize));
-	stream.write((char*)&normals[0], normalSize * sizeof(vec3));
+	stream.write((const char*)getNormals().data(), normalSize * sizeof(vec3));
 
-	size_t faceSize = faces.size();
+	size_t faceSize = getFaces().size();
 	stream.write((char*)&faceSize, sizeof(faceSize));
-	stream.write((char*)&faces[0], faceSize * sizeof(ivec3));
+	stream.write((const char*)getFaces().data(), faceSize * sizeof(ivec3));
 
-	size_t indicesSize = indices.size();
+	size_t indicesSize = getIndices().size();
 	stream.write((char*)&indicesSize, sizeof(indicesSize));
 	if(indicesSize > 0)
-		stream.write((char*)&indices[0], indicesSize * sizeof(i32));
+		stream.write((const char*)getIndices().data(), indicesSize * sizeof(i32));
 
 	stream.write((char*)&color[0], 3 * sizeof(f32));
 }
@@ -167,4 +271,7 @@ void Mesh::deserialize(std::istream& stream)
 		stream.read((char*)&indices[0], indicesSize * sizeof(i32));
 
 	stream.read((char*)&color[0], 3 * sizeof(f32));
+
+	// Not stored, they are rebuilt from the geometry
+	buildLods();
 }
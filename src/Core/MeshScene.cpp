@@ -12,6 +12,14 @@ using NoxEngineUtils::Logger;
 MeshScene::MeshScene() { }
 MeshScene::~MeshScene() { }
 
+void MeshScene::setGeometryKeys(const String& sourceFile)
+{
+	for (u32 i = 0; i < meshes.size(); i++)
+	{
+		meshes[i]->geometryKey = sourceFile + "#" + std::to_string(i);
+	}
+}
+
 MeshScene::MeshScene(const aiScene* scene) :
 	frameIndex(0),
 	animationIndex(0),
@@ -440,10 +448,25 @@ void MeshScene::extractGeometricInfo(const aiScene* scene) {
 		}
 
 		// mesh->prepTheData();
+
+		// Assimp's order ignores the vertex cache, LODs are built after so they share the new vertex order
+		VertexCacheStats cacheStats = mesh->optimizeIndexOrder();
+		vertexCacheStats.triangles += cacheStats.triangles;
+		vertexCacheStats.acmrBefore += cacheStats.acmrBefore * cacheStats.triangles;
+		vertexCacheStats.acmrAfter += cacheStats.acmrAfter * cacheStats.triangles;
+
+		mesh->buildLods();
 		meshes.push_back(mesh);
 
 	}
 
+	if (vertexCacheStats.triangles > 0) {
+		vertexCacheStats.acmrBefore /= vertexCacheStats.triangles;
+		vertexCacheStats.acmrAfter /= vertexCacheStats.triangles;
+		Logger::debug("Vertex cache: %u triangles, ACMR %.3f before, %.3f after", vertexCacheStats.triangles,
+				vertexCacheStats.acmrBefore, vertexCacheStats.acmrAfter);
+	}
+
 
 
 	// aiMesh** loadedMesh = scene->mMeshes;
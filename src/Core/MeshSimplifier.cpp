@@ -0,0 +1,243 @@
+#include <Core/MeshSimplifier.h>
+#include <Core/VertexCacheOptimizer.h>
+#include <Core/AABBTree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace NoxEngine;
+
+// Meshes smaller than this aren't worth the extra index ranges
+static const u32 MinLodTriangles = 64;
+// Largest error a level may have, as a fraction of the bounds diagonal
+static const f32 MaxLodError = 0.05f;
+
+namespace {
+
+	// Symmetric 4x4 matrix of the summed plane equations, eval(p) is the sum of squared distances to the planes
+	struct Quadric {
+		f64 a00, a01, a02, a11, a12, a22;
+		f64 b0, b1, b2;
+		f64 c;
+
+		static Quadric fromPlane(const glm::dvec3 &n, f64 d) {
+			return { n.x * n.x, n.x * n.y, n.x * n.z, n.y * n.y, n.y * n.z, n.z * n.z, n.x * d, n.y * d, n.z * d, d * d };
+		}
+
+		Quadric& operator+=(const Quadric &q) {
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			return *this;
+		}
+
+		f64 eval(const vec3 &p) const {
+			f64 x = p.x, y = p.y, z = p.z;
+			f64 error = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + a11 * y * y + 2.0 * a12 * y * z + a22 * z * z
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return std::max(error, 0.0);
+		}
+	};
+
+	struct Collapse {
+		u32 from;
+		u32 to;
+		f64 cost;
+	};
+
+	inline u64 edgeKey(u32 a, u32 b) {
+		return a < b ? (u64)a << 32 | b : (u64)b << 32 | a;
+	}
+
+	// Every edge of the triangles once, sorted
+	void collectEdges(const Array<i32> &indices, Array<u64> &edges, bool keepDuplicates) {
+		edges.clear();
+		for (u32 i = 0; i < indices.size(); i += 3) {
+			edges.push_back(edgeKey(indices[i + 0], indices[i + 1]));
+			edges.push_back(edgeKey(indices[i + 1], indices[i + 2]));
+			edges.push_back(edgeKey(indices[i + 2], indices[i + 0]));
+		}
+
+		std::sort(edges.begin(), edges.end());
+		if (!keepDuplicates) edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+	}
+
+	// Triangles around each vertex, triangles of vertex v are adjacency[offsets[v]] to adjacency[offsets[v + 1]]
+	void buildAdjacency(const Array<i32> &indices, u32 vertexCount, Array<u32> &offsets, Array<u32> &adjacency) {
+		offsets.assign(vertexCount + 1, 0);
+		for (i32 index : indices) offsets[index + 1]++;
+		for (u32 v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+		adjacency.resize(indices.size());
+		Array<u32> fill(offsets.begin(), offsets.end() - 1);
+		for (u32 i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	bool collapseFlips(const Array<vec3> &positions, const Array<i32> &indices, const Array<u32> &offsets,
+			const Array<u32> &adjacency, u32 from, u32 to)
+	{
+		for (u32 i = offsets[from]; i < offsets[from + 1]; i++) {
+			const i32 *triangle = &indices[adjacency[i] * 3];
+
+			// Triangles on the collapsed edge disappear
+			if (triangle[0] == (i32)to || triangle[1] == (i32)to || triangle[2] == (i32)to) continue;
+
+			vec3 p[3], moved[3];
+			for (u32 j = 0; j < 3; j++) {
+				p[j] = positions[triangle[j]];
+				moved[j] = triangle[j] == (i32)from ? positions[to] : p[j];
+			}
+
+			vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+			// Turned over or close to it
+			if (glm::dot(before, after) <= 0.1f * glm::length(before) * glm::length(after)) return true;
+		}
+
+		return false;
+	}
+}
+
+f32 NoxEngine::simplifyMesh(const Array<vec3> &positions, const Array<i32> &indices, u32 targetIndexCount, f32 maxError, Array<i32> &result) {
+
+	u32 vertexCount = (u32)positions.size();
+	result = indices;
+
+	Array<Quadric> quadrics(vertexCount, Quadric{});
+	for (u32 i = 0; i < indices.size(); i += 3) {
+		glm::dvec3 p0 = positions[indices[i + 0]];
+		glm::dvec3 p1 = positions[indices[i + 1]];
+		glm::dvec3 p2 = positions[indices[i + 2]];
+
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		f64 length = glm::length(normal);
+		if (length == 0.0) continue;
+
+		normal /= length;
+		Quadric plane = Quadric::fromPlane(normal, -glm::dot(normal, p0));
+		for (u32 j = 0; j < 3; j++) quadrics[indices[i + j]] += plane;
+	}
+
+	// An edge only one triangle uses is open
+	Array<u64> edges;
+	Array<u8> locked(vertexCount, 0);
+	collectEdges(indices, edges, true);
+	for (u32 i = 0; i < edges.size();) {
+		u32 run = 1;
+		while (i + run < edges.size() && edges[i + run] == edges[i]) run++;
+		if (run == 1) {
+			locked[edges[i] >> 32] = 1;
+			locked[edges[i] & 0xFFFFFFFF] = 1;
+		}
+		i += run;
+	}
+
+	Array<Collapse> candidates;
+	Array<u32> offsets, adjacency, remap(vertexCount);
+	Array<u8> touched;
+	f64 maxCost = (f64)maxError * maxError;
+	f32 resultError = 0.0f;
+
+	while (result.size() > targetIndexCount) {
+
+		collectEdges(result, edges, false);
+
+		candidates.clear();
+		for (u64 edge : edges) {
+			u32 a = (u32)(edge >> 32);
+			u32 b = (u32)(edge & 0xFFFFFFFF);
+			if (locked[a] && locked[b]) continue;
+
+			Quadric q = quadrics[a];
+			q += quadrics[b];
+
+			f64 costToB = locked[a] ? std::numeric_limits<f64>::max() : q.eval(positions[b]);
+			f64 costToA = locked[b] ? std::numeric_limits<f64>::max() : q.eval(positions[a]);
+
+			if (costToB <= costToA) candidates.push_back({ a, b, costToB });
+			else candidates.push_back({ b, a, costToA });
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+		buildAdjacency(result, vertexCount, offsets, adjacency);
+		touched.assign(vertexCount, 0);
+		for (u32 v = 0; v < vertexCount; v++) remap[v] = v;
+
+		// An interior collapse takes two triangles with it, don't overshoot the target by much
+		u32 budget = std::max((u32)(result.size() - targetIndexCount) / 6, 1u);
+		u32 collapses = 0;
+
+		for (const Collapse &collapse : candidates) {
+			if (collapses >= budget || collapse.cost > maxCost) break;
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+			if (collapseFlips(positions, result, offsets, adjacency, collapse.from, collapse.to)) continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+
+			// Everything sharing a triangle with the moved vertex waits for the next pass, the flip tests
+			// above are only right for triangles no other collapse of this pass has changed
+			for (u32 i = offsets[collapse.from]; i < offsets[collapse.from + 1]; i++) {
+				const i32 *triangle = &result[adjacency[i] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+			}
+
+			resultError = std::max(resultError, (f32)std::sqrt(collapse.cost));
+			collapses++;
+		}
+
+		if (collapses == 0) break;
+
+		// Triangles that lost an edge are dropped
+		u32 write = 0;
+		for (u32 i = 0; i < result.size(); i += 3) {
+			i32 a = remap[result[i + 0]];
+			i32 b = remap[result[i + 1]];
+			i32 c = remap[result[i + 2]];
+			if (a == b || b == c || a == c) continue;
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	return resultError;
+}
+
+f32 NoxEngine::lodErrorBound(const Array<vec3> &positions) {
+
+	AABB bounds = computeAABB(positions);
+	return glm::length(bounds.max - bounds.min) * MaxLodError;
+}
+
+void NoxEngine::generateLods(const Array<vec3> &positions, const Array<i32> &indices, Array<LodLevel> &lods) {
+
+	lods.clear();
+	if (indices.size() / 3 < MinLodTriangles * 2) return;
+
+	f32 maxError = lodErrorBound(positions);
+
+	// Every level starts from the full mesh so its error is measured against the original surface
+	u32 previousCount = (u32)indices.size();
+	for (u32 level = 1; level < kMaxLodLevels; level++) {
+		u32 target = (u32)(indices.size() >> level) / 3 * 3;
+		if (target / 3 < MinLodTriangles) break;
+
+		LodLevel lod;
+		lod.error = simplifyMesh(positions, indices, target, maxError, lod.indices);
+
+		// Held back by the error bound or the locked vertices, the next levels wouldn't do better
+		if (lod.indices.size() > previousCount * 3 / 4) break;
+
+		// Collapses leave the triangles in the full mesh's order with holes, put them back in cache order
+		optimizeVertexCache(lod.indices, (u32)positions.size());
+
+		previousCount = (u32)lod.indices.size();
+		lods.push_back(std::move(lod));
+	}
+}
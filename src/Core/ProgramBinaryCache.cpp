@@ -0,0 +1,153 @@
+#include <Core/ProgramBinaryCache.h>
+#include <Utils/Utils.h>
+
+#include <filesystem>
+#include <fstream>
+
+using namespace NoxEngine;
+
+// Bump when the file layout changes
+static const u32 kCacheMagic = 0x4E585042; // "NXPB"
+static const u32 kCacheVersion = 1;
+
+struct BinaryHeader {
+	u32 magic;
+	u32 version;
+	u32 format;
+	u32 length;
+};
+
+static u64 fnv1a(u64 hash, const void *data, size_t size) {
+	const u8 *bytes = (const u8*)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+static String glString(GLenum name) {
+	const char *value = (const char*)glGetString(name);
+	return value ? String(value) : String();
+}
+
+ProgramBinaryCache::ProgramBinaryCache() :
+	_directory("cache/shaders"),
+	_driver(),
+	_enabled(false),
+	_parallelCompile(false)
+{
+	_driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+	// Some drivers expose the entry points but no binary formats, nothing could be stored then
+	i32 formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	_enabled = formatCount > 0;
+
+	std::error_code error;
+	std::filesystem::create_directories(_directory, error);
+	if (error) {
+		LOG_DEBUG("Can't create shader cache directory %s, binaries won't be cached", _directory.c_str());
+		_enabled = false;
+	}
+
+	if (GLAD_GL_KHR_parallel_shader_compile) {
+		// Let the driver pick the number of threads
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		_parallelCompile = true;
+	}
+}
+
+u64 ProgramBinaryCache::makeKey(const Array<String> &sources, const Array<u32> &shaderTypes) const {
+
+	u64 hash = 0xCBF29CE484222325ull;
+	hash = fnv1a(hash, &kCacheVersion, sizeof(kCacheVersion));
+	hash = fnv1a(hash, _driver.data(), _driver.size());
+
+	for (u32 i = 0; i < sources.size(); i++) {
+		u32 length = (u32)sources[i].size();
+		hash = fnv1a(hash, &shaderTypes[i], sizeof(u32));
+		hash = fnv1a(hash, &length, sizeof(length));
+		hash = fnv1a(hash, sources[i].data(), length);
+	}
+
+	return hash;
+}
+
+String ProgramBinaryCache::pathFor(u64 key) const {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return _directory + "/" + name;
+}
+
+bool ProgramBinaryCache::load(u64 key, GLuint program) {
+
+	if (!_enabled) return false;
+
+	String path = pathFor(key);
+	std::ifstream input(path, std::ios::binary);
+	if (!input) return false;
+
+	BinaryHeader header;
+	input.read((char*)&header, sizeof(header));
+
+	bool valid = input && header.magic == kCacheMagic && header.version == kCacheVersion && header.length > 0;
+
+	Array<u8> binary;
+	if (valid) {
+		binary.resize(header.length);
+		input.read((char*)binary.data(), header.length);
+		valid = (bool)input;
+	}
+
+	input.close();
+
+	if (valid) {
+		glProgramBinary(program, header.format, binary.data(), header.length);
+
+		i32 linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		valid = linked == GL_TRUE;
+	}
+
+	// Truncated, stale or rejected by the driver, drop it so the fresh binary replaces it
+	if (!valid) {
+		LOG_DEBUG("Discarding shader cache entry %s", path.c_str());
+		std::error_code error;
+		std::filesystem::remove(path, error);
+	}
+
+	return valid;
+}
+
+void ProgramBinaryCache::store(u64 key, GLuint program) {
+
+	if (!_enabled) return;
+
+	i32 length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	Array<u8> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+	if (length <= 0) return;
+
+	BinaryHeader header = { kCacheMagic, kCacheVersion, format, (u32)length };
+
+	// Written aside and renamed so a crash mid-write never leaves a truncated entry behind
+	String path = pathFor(key);
+	String tempPath = path + ".tmp";
+
+	std::ofstream output(tempPath, std::ios::binary);
+	output.write((const char*)&header, sizeof(header));
+	output.write((const char*)binary.data(), length);
+	output.close();
+
+	std::error_code error;
+	if (output) std::filesystem::rename(tempPath, path, error);
+	if (!output || error) {
+		LOG_DEBUG("Failed to write shader cache entry %s", path.c_str());
+		std::filesystem::remove(tempPath, error);
+	}
+}
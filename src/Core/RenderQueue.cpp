@@ -0,0 +1,73 @@
+#include <Core/RenderQueue.h>
+
+#include <algorithm>
+
+using namespace NoxEngine;
+
+static inline u64 field(u64 value, u32 bits) {
+	return value & ((1ull << bits) - 1);
+}
+
+u64 RenderQueue::makeKey(u32 program, u32 renderType, u32 indexType, u32 ambientTexture, u32 normalTexture, u32 geometry, f32 depth) {
+
+	// Depth is expected in [0, 1], nearest first
+	u64 depthBits = (u64)(std::clamp(depth, 0.0f, 1.0f) * ((1 << 14) - 1));
+
+	return field(program, 4) << 60 |
+		field(renderType, 3) << 57 |
+		field(indexType, 1) << 56 |
+		field(ambientTexture, 12) << 44 |
+		field(normalTexture, 12) << 32 |
+		field(geometry, 18) << 14 |
+		depthBits;
+}
+
+u64 RenderQueue::makeDepthKey(u32 renderType, u32 indexType, u32 ambientTexture, u32 normalTexture, u32 geometry, f32 depth) {
+
+	// 256 buckets front to back, within a bucket state is grouped like in makeKey
+	f32 depth01 = std::clamp(depth, 0.0f, 1.0f);
+	u64 bucket = (u64)(depth01 * ((1 << 8) - 1));
+	u64 depthBits = (u64)(depth01 * ((1 << 10) - 1));
+
+	return bucket << 56 |
+		field(renderType, 3) << 53 |
+		field(indexType, 1) << 52 |
+		field(ambientTexture, 12) << 40 |
+		field(normalTexture, 12) << 28 |
+		field(geometry, 18) << 10 |
+		depthBits;
+}
+
+void RenderQueue::sort() {
+
+	u32 count = (u32)_items.size();
+	if (count < 2) return;
+
+	_scratch.resize(count);
+
+	// Bytes where every key agrees don't change the order
+	u64 allOnes = ~0ull, allZeros = 0;
+	for (const RenderItem &item : _items) {
+		allOnes &= item.key;
+		allZeros |= item.key;
+	}
+	u64 varying = allOnes ^ allZeros;
+
+	for (u32 shift = 0; shift < 64; shift += 8) {
+		if (((varying >> shift) & 0xFF) == 0) continue;
+
+		u32 offsets[256] = {};
+		for (const RenderItem &item : _items) offsets[(item.key >> shift) & 0xFF]++;
+
+		u32 offset = 0;
+		for (u32 i = 0; i < 256; i++) {
+			u32 bucket = offsets[i];
+			offsets[i] = offset;
+			offset += bucket;
+		}
+
+		for (const RenderItem &item : _items) _scratch[offsets[(item.key >> shift) & 0xFF]++] = item;
+
+		_items.swap(_scratch);
+	}
+}
@@ -1,6 +1,10 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <glm/glm.hpp>
 #include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
 #include <Core/Types.h>
 #include <Core/Renderer.h>
@@ -10,7 +14,9 @@
 #include <Components/AudioGeometryComponent.h>
 #include <Components/AudioListenerComponent.h>
 #include <Components/EmissionComponent.h>
+#include <Components/AnimationComponent.h>
 #include <Managers/LiveReloadManager.h>
+#include <Core/GpuProfiler.h>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/euler_angles.hpp>
@@ -24,52 +30,92 @@
 using NoxEngineUtils::Logger;
 using namespace NoxEngine;
 
+// Never a TransformComponent version, forces the next refit
+static const u32 StaleTransform = ~0u;
+
 Renderer::~Renderer()
 {
-    vertices.clear();
-    normals.clear();
-    texCoords.clear();
-    elements.clear();
+    clearObject();
 
     glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &NBO);
-    glDeleteBuffers(1, &TCBO);
-    glDeleteBuffers(1, &EBO);
+    delete vertexPool;
+    delete elementPool;
+
+    glDeleteBuffers(1, &drawIdBuffer);
+    glDeleteBuffers(1, &lightSSBO);
+    delete lightClusters;
 
     // Remove shader
     // Remove framebuffer
     glDeleteFramebuffers(1, &FBO);
+
+    delete upscaler;
+    glDeleteFramebuffers(1, &outputFBO);
+    glDeleteTextures(1, &outputTexture);
+    glDeleteVertexArrays(1, &upscaleVAO);
+    glDeleteBuffers(1, &upscaleIndexBuffer);
+
+    delete depthProgram;
+    delete overdrawProgram;
+    delete gridProgram;
+    glDeleteQueries(1, &shadedQuery);
+
+    delete hiZ;
 }
 
 Renderer::Renderer(int width, int height, Camera* cam) :
 	w(width),
 	h(height),
 	camera(cam),
-	elements(0),
 	projection(0),
 	cam(0),
 	objects(),
-	VBO(0),
-	NBO(0),
-	TCBO(0),
-	EBO(0),
-	TANBO(0),
+	vertexPool(nullptr),
+	elementPool(nullptr),
+	drawIdBuffer(0),
+	drawIdCapacity(0),
+	useIndirectDraw(true),
+	indirectOffset(0),
+	prepassBatchCount(0),
+	useDepthPrepass(false),
+	useFrontToBack(false),
+	showOverdraw(false),
+	depthProgram(nullptr),
+	overdrawProgram(nullptr),
+	shadedQuery(0),
+	shadedQueryPending(false),
+	lightSSBO(0),
+	lightSSBOCapacity(0),
+	lightsDirtyBegin(0),
+	lightsDirtyEnd(0),
+	lightSetVersion(0),
+	lightClusters(nullptr),
+	useFrustumCulling(true),
+	cullTree(),
+	visibleObjects(),
+	useOcclusionCulling(false),
+	lodPixelError(1.0f),
+	showGrid(true),
+	gridSpacing(20.0f),
+	gridFadeDistance(1500.0f),
+	gridProgram(nullptr),
+	hiZ(nullptr),
+	VAO(0),
 	FBO(0),
-	numberOfVertices(0),
-	numberOfNormals(0),
-	numberOfElements(0),
-	numOfTexCoords(0),
-	numOfTangents(0),
-	vertices(0),
-	normals(0),
-	texCoords(0),
-	tangents(0),
 	textureToRenderTo(0),
 	tex(0),
 	curFBO(0),
+	renderScale(1.0f),
+	renderWidth(width),
+	renderHeight(height),
+	outputFBO(0),
+	outputTexture(0),
+	upscaleVAO(0),
+	upscaleIndexBuffer(0),
+	upscaler(nullptr),
+	upscaleSharpness(0.0f),
+	dynamicResolution(),
 	color(0),
-	nextObjectId(0),
 	program(nullptr)
 {
 
@@ -83,68 +129,164 @@ Renderer::Renderer(int width, int height, Camera* cam) :
 	glGenFramebuffers(1, &FBO);
 	glGenTextures(1, &depthStencilTexture);
     glGenTextures(1, &textureToRenderTo);
+	glGenFramebuffers(1, &outputFBO);
+	glGenTextures(1, &outputTexture);
 
 	updateTextureSizes(width, height);
     
 	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::Instance()->invalidate();
     // Generate buffer handlers
-    glGenVertexArrays(1, &VAO);
+    glCreateVertexArrays(1, &VAO);
+
+	// Pools start with room for a few meshes and double when full.
+	// The element pool is addressed in bytes since objects mix 16 and 32 bit indices
+	vertexPool = new GeometryPool(1 << 16, { sizeof(PackedVertex) });
+	elementPool = new GeometryPool(1 << 20, { 1 });
+	geometryStats = {};
 
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &NBO);
-    glGenBuffers(1, &TCBO);
-    glGenBuffers(1, &TANBO);
-    glGenBuffers(1, &EBO);
+	setupVertexFormat();
+	setupShaderBuffers();
 
 	setupSkybox();
+	setupUpscale();
+	setupDepthPrepass();
+
+	hiZ = new HiZBuffer();
 }
 
-void Renderer::updateBuffers() {
+void Renderer::setupDepthPrepass() {
 
-	program->use();
-	program->printAttribInfo();
-	// Bind vert attribute handle
-	glBindVertexArray(VAO);
+	depthProgram = new GLProgram(Array<ShaderFile>{
+		{ "assets/shaders/depthPrepass.vert", GL_VERTEX_SHADER, 0 },
+		{ "assets/shaders/depthPrepass.frag", GL_FRAGMENT_SHADER, 0 },
+	});
 
-	// Update GPU containers
-	
-	// Vertice positions
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vec3), vertices.data(), GL_STATIC_DRAW);
+	overdrawProgram = new GLProgram(Array<ShaderFile>{
+		{ "assets/shaders/depthPrepass.vert", GL_VERTEX_SHADER, 0 },
+		{ "assets/shaders/overdraw.frag", GL_FRAGMENT_SHADER, 0 },
+	});
+
+	glCreateQueries(GL_SAMPLES_PASSED, 1, &shadedQuery);
+}
+
+void Renderer::setupUpscale() {
+
+	// Same quad as GameManager's post processing, the vertex shader makes the corners from the indices
+	u32 indices[6] = { 0, 2, 1, 0, 3, 2 };
 
-	int positionAtr = program->getAtrributeLocation("position");
-	glVertexAttribPointer(positionAtr, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	glEnableVertexArrayAttrib(VAO, positionAtr);
+	glCreateBuffers(1, &upscaleIndexBuffer);
+	glNamedBufferStorage(upscaleIndexBuffer, sizeof(indices), indices, 0);
 
-	// Normal positions
-    glBindBuffer(GL_ARRAY_BUFFER, NBO);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(vec3), normals.data(), GL_STATIC_DRAW);
+	glCreateVertexArrays(1, &upscaleVAO);
+	glVertexArrayElementBuffer(upscaleVAO, upscaleIndexBuffer);
 
-	int normalAtr = program->getAtrributeLocation("normal");
-	glVertexAttribPointer(normalAtr, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	glEnableVertexArrayAttrib(VAO, normalAtr);
+	upscaler = new FullscreenShader("assets/shaders/upscale.frag", { { kMainRendererInput, 0 } }, "Upscale");
 
-	// Tex Coords positions
-	glBindBuffer(GL_ARRAY_BUFFER, TCBO);
-	glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(vec2), texCoords.data(), GL_STATIC_DRAW);
+	gridProgram = new GLProgram(Array<ShaderFile>{
+		{ "assets/shaders/grid.vert", GL_VERTEX_SHADER, 0 },
+		{ "assets/shaders/grid.frag", GL_FRAGMENT_SHADER, 0 },
+	});
+}
+
+void Renderer::setupVertexFormat() {
 
-	int texCoordAtr = program->getAtrributeLocation("texCoord");
-	glVertexAttribPointer(texCoordAtr, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	glEnableVertexArrayAttrib(VAO, texCoordAtr);
+	// Fixed attribute locations, the format never changes, only the buffers behind binding 0 do
+	glEnableVertexArrayAttrib(VAO, PositionAttrib);
+	glVertexArrayAttribFormat(VAO, PositionAttrib, 3, GL_FLOAT, GL_FALSE, offsetof(PackedVertex, position));
+	glVertexArrayAttribBinding(VAO, PositionAttrib, 0);
 
-    // Tangents
-    glBindBuffer(GL_ARRAY_BUFFER, TANBO);
-    glBufferData(GL_ARRAY_BUFFER, tangents.size() * sizeof(vec3), tangents.data(), GL_STATIC_DRAW);
+	glEnableVertexArrayAttrib(VAO, NormalAttrib);
+	glVertexArrayAttribFormat(VAO, NormalAttrib, 2, GL_SHORT, GL_TRUE, offsetof(PackedVertex, normal));
+	glVertexArrayAttribBinding(VAO, NormalAttrib, 0);
 
-    int tangentAtr = program->getAtrributeLocation("tangent");
-    glVertexAttribPointer(tangentAtr, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glEnableVertexArrayAttrib(VAO, tangentAtr);
+	glEnableVertexArrayAttrib(VAO, TexCoordAttrib);
+	glVertexArrayAttribFormat(VAO, TexCoordAttrib, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, texCoord));
+	glVertexArrayAttribBinding(VAO, TexCoordAttrib, 0);
 
-    // Elements
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * sizeof(i32), elements.data(), GL_STATIC_DRAW);
+	// Draw id comes from binding 1, advanced once per instance and offset by the base instance of the draw
+	glEnableVertexArrayAttrib(VAO, DrawIdAttrib);
+	glVertexArrayAttribIFormat(VAO, DrawIdAttrib, 1, GL_UNSIGNED_INT, 0);
+	glVertexArrayAttribBinding(VAO, DrawIdAttrib, 1);
+	glVertexArrayBindingDivisor(VAO, 1, 1);
 
-    glBindVertexArray(0);
+	updateBuffers();
+}
+
+void Renderer::setupShaderBuffers() {
+
+	glCreateBuffers(1, &drawIdBuffer);
+
+	// Never left empty so there is always something bound to the light binding
+	lightSSBOCapacity = 16;
+	glCreateBuffers(1, &lightSSBO);
+	glNamedBufferData(lightSSBO, lightSSBOCapacity * sizeof(LightUniforms), NULL, GL_DYNAMIC_DRAW);
+
+	lightClusters = new LightClusters();
+
+	renderStats = {};
+}
+
+void Renderer::uploadObjectUniforms() {
+
+	u32 count = (u32)objectUniforms.size();
+
+	// Only ever grows, doubling to keep reallocations rare
+	if (count > drawIdCapacity) {
+		drawIdCapacity = std::max(count, drawIdCapacity * 2);
+
+		Array<u32> ids(drawIdCapacity);
+		for (u32 i = 0; i < drawIdCapacity; i++) ids[i] = i;
+
+		glNamedBufferData(drawIdBuffer, drawIdCapacity * sizeof(u32), ids.data(), GL_STATIC_DRAW);
+		glVertexArrayVertexBuffer(VAO, 1, drawIdBuffer, 0, sizeof(u32));
+	}
+
+	// Never an empty range, those can't be bound
+	StreamRange range = StreamBuffer::Instance()->allocate(std::max(count, 1u) * sizeof(ObjectUniforms));
+	if (count > 0) memcpy(range.data, objectUniforms.data(), count * sizeof(ObjectUniforms));
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, ObjectBufferBinding, range.buffer, range.offset, range.size);
+}
+
+void Renderer::uploadLights() {
+
+	u32 count = (u32)lightUniforms.size();
+
+	if (count > lightSSBOCapacity) {
+		lightSSBOCapacity = std::max(count, lightSSBOCapacity * 2);
+		glNamedBufferData(lightSSBO, lightSSBOCapacity * sizeof(LightUniforms), NULL, GL_DYNAMIC_DRAW);
+
+		lightsDirtyBegin = 0;
+		lightsDirtyEnd = count;
+	}
+
+	lightsDirtyEnd = std::min(lightsDirtyEnd, count);
+	if (lightsDirtyBegin < lightsDirtyEnd) {
+		glNamedBufferSubData(lightSSBO, lightsDirtyBegin * sizeof(LightUniforms),
+				(lightsDirtyEnd - lightsDirtyBegin) * sizeof(LightUniforms), &lightUniforms[lightsDirtyBegin]);
+	}
+
+	lightsDirtyBegin = 0;
+	lightsDirtyEnd = 0;
+}
+
+void Renderer::markLightDirty(u32 lightInd) {
+	if (lightsDirtyBegin == lightsDirtyEnd) {
+		lightsDirtyBegin = lightInd;
+		lightsDirtyEnd = lightInd + 1;
+		return;
+	}
+
+	lightsDirtyBegin = std::min(lightsDirtyBegin, lightInd);
+	lightsDirtyEnd = std::max(lightsDirtyEnd, lightInd + 1);
+}
+
+void Renderer::updateBuffers() {
+
+	// Only (re)binds the pool buffers to the VAO, needed after a pool has grown.
+	// The geometry itself is uploaded per object when it is added
+	glVertexArrayVertexBuffer(VAO, 0, vertexPool->getBuffer(0), 0, sizeof(PackedVertex));
+	glVertexArrayElementBuffer(VAO, elementPool->getBuffer(0));
 }
 
 
@@ -154,56 +296,173 @@ RendObj Renderer::createRendObject(IRenderable *mesh) {
 	newObj.meshSrc = mesh;
 
 	newObj.renderType = mesh->glRenderType;
-	newObj.startInd = (i32)elements.size();
 	newObj.has_texture = mesh->has_texture;
 	newObj.has_normal = mesh->has_normal;
 
-	// Generate textures for the object
+	newObj.transformation = mat4(1.0f);
+	newObj.worldTransform = mat4(1.0f);
+	newObj.boundsTransform = mat4(1.0f);
+	newObj.transformVersion = StaleTransform;
+	newObj.cullProxy = AABBTree::NullNode;
+
+	// Geometry already on the GPU for another object with the same key is reused as is,
+	// objects sharing it end up next to each other in draw() and are drawn instanced
+	if (!mesh->geometryKey.empty()) {
+		auto shared = sharedGeometry.find(mesh->geometryKey);
+		if (shared != sharedGeometry.end()) {
+			shared->second.refCount++;
+
+			newObj.geometryKey = mesh->geometryKey;
+			newObj.vertexRange = shared->second.vertexRange;
+			newObj.elementRange = shared->second.elementRange;
+			newObj.indexType = shared->second.indexType;
+			newObj.indexCount = shared->second.indexCount;
+			newObj.localBounds = shared->second.bounds;
+			newObj.lodCount = shared->second.lodCount;
+			std::copy(shared->second.lods, shared->second.lods + kMaxLodLevels, newObj.lods);
+
+			if(mesh->has_texture) {
+				newObj.ambientTexturePath = mesh->getAmbientTexture();
+				newObj.normalTexturePath = mesh->getNormalTexture();
+				newObj.ambientTexture = setTexture(newObj.ambientTexturePath, "AmbTexture", 1);
+				newObj.normalTexture = setTexture(newObj.normalTexturePath, "NormTexture", 2, TextureCache::FlatNormalPlaceholder);
+			}
+
+			return newObj;
+		}
+	}
+
+	// Generate textures for the object, objects using the same files get the same handles
 	if(mesh->has_texture) {
-		newObj.ambientTexture = setTexture(mesh->getAmbientTexture(), "AmbTexture", 1);
-		newObj.normalTexture = setTexture(mesh->getNormalTexture(), "NormTexture", 2);
+		newObj.ambientTexturePath = mesh->getAmbientTexture();
+		newObj.normalTexturePath = mesh->getNormalTexture();
+		newObj.ambientTexture = setTexture(newObj.ambientTexturePath, "AmbTexture", 1);
+		newObj.normalTexture = setTexture(newObj.normalTexturePath, "NormTexture", 2, TextureCache::FlatNormalPlaceholder);
 	}
 
-	// Generate the arrays
-	createVertexArray(mesh);
+	// Indices are relative to the object's first vertex, so 16 bits are enough for most meshes
+	u32 numOfVertices = (u32)mesh->getVertices().size();
+	newObj.indexType = numOfVertices <= 0xFFFF + 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	newObj.indexCount = mesh->use_indices ? (i32)mesh->getIndices().size() : (i32)mesh->getFaces().size() * 3;
+	newObj.localBounds = computeAABB(mesh->getVertices());
 
-	if(mesh->has_texture) createTexCoordArray(mesh);
-	if(mesh->has_normal) createNormalsArray(mesh);
+	// Element ranges are kept 4 byte aligned so either index type can start anywhere in the pool
+	u32 indexSize = newObj.indexType == GL_UNSIGNED_SHORT ? sizeof(u16) : sizeof(u32);
+	u32 elementBytes = (newObj.indexCount * indexSize + 3) & ~3u;
 
-	if(mesh->has_normal && mesh->has_texture) createTangents(mesh);
+	// Coarser levels follow the full one in the same range, each aligned the same way
+	newObj.lodCount = 1;
+	newObj.lods[0] = { 0, newObj.indexCount, 0.0f };
+	for (const LodLevel &level : mesh->getLods()) {
+		if (newObj.lodCount == kMaxLodLevels) break;
 
-	createElementArray(mesh);
+		newObj.lods[newObj.lodCount++] = { elementBytes, (i32)level.indices.size(), level.error };
+		elementBytes += ((u32)level.indices.size() * indexSize + 3) & ~3u;
+	}
 
-	newObj.endInd = i32(elements.size());
-	newObj.transformation = mat4(1.0f);
+	// Reserve space in the pools, if one of them had to grow the VAO points to stale buffers
+	bool vertexPoolGrown = vertexPool->allocate(numOfVertices, newObj.vertexRange);
+	bool elementPoolGrown = elementPool->allocate(elementBytes, newObj.elementRange);
+
+	if (vertexPoolGrown || elementPoolGrown) updateBuffers();
+
+	// Upload only this object's part of the buffers
+	createVertexArray(mesh, newObj.vertexRange);
+	createElementArray(mesh, newObj);
+
+	if (!mesh->geometryKey.empty()) {
+		newObj.geometryKey = mesh->geometryKey;
+		SharedGeometry &shared = sharedGeometry[newObj.geometryKey];
+		shared.vertexRange = newObj.vertexRange;
+		shared.elementRange = newObj.elementRange;
+		shared.indexType = newObj.indexType;
+		shared.indexCount = newObj.indexCount;
+		shared.refCount = 1;
+		shared.bounds = newObj.localBounds;
+		shared.lodCount = newObj.lodCount;
+		std::copy(newObj.lods, newObj.lods + kMaxLodLevels, shared.lods);
+	}
+
+	geometryStats.vertices += numOfVertices;
+	geometryStats.indices += newObj.indexCount;
+	geometryStats.residentBytes += newObj.vertexRange.count * sizeof(PackedVertex) + newObj.elementRange.count;
+	geometryStats.lodBytes += newObj.lodCount > 1 ? newObj.elementRange.count - newObj.lods[1].elementOffset : 0;
+	geometryStats.legacyResidentBytes += numOfVertices * kUnpackedVertexSize + newObj.indexCount * sizeof(i32);
 
 	return newObj;
 }
 
+void Renderer::releaseRendObject(RendObj &obj) {
+
+	if (obj.cullProxy != AABBTree::NullNode) {
+		cullTree.destroyProxy(obj.cullProxy);
+		obj.cullProxy = AABBTree::NullNode;
+	}
+
+	if (obj.ambientTexture != 0) textureCache.release(obj.ambientTexture);
+	if (obj.normalTexture != 0) textureCache.release(obj.normalTexture);
+	obj.ambientTexture = 0;
+	obj.normalTexture = 0;
+
+	// Shared geometry stays until the last object using it is gone
+	bool releaseRanges = true;
+	if (!obj.geometryKey.empty()) {
+		auto shared = sharedGeometry.find(obj.geometryKey);
+		if (shared != sharedGeometry.end()) {
+			if (--shared->second.refCount > 0) releaseRanges = false;
+			else sharedGeometry.erase(shared);
+		}
+	}
+
+	if (!releaseRanges) {
+		obj.vertexRange = { 0, 0 };
+		obj.elementRange = { 0, 0 };
+		obj.indexCount = 0;
+		return;
+	}
+
+	geometryStats.vertices -= obj.vertexRange.count;
+	geometryStats.indices -= obj.indexCount;
+	geometryStats.residentBytes -= obj.vertexRange.count * sizeof(PackedVertex) + obj.elementRange.count;
+	geometryStats.lodBytes -= obj.lodCount > 1 ? obj.elementRange.count - obj.lods[1].elementOffset : 0;
+	geometryStats.legacyResidentBytes -= obj.vertexRange.count * kUnpackedVertexSize + obj.indexCount * sizeof(i32);
+
+	// Give the ranges back to the pools, the next added object can reuse them
+	vertexPool->release(obj.vertexRange);
+	elementPool->release(obj.elementRange);
+
+	obj.vertexRange = { 0, 0 };
+	obj.elementRange = { 0, 0 };
+	obj.indexCount = 0;
+}
+
 void Renderer::addObject(Entity *ent, IRenderable *meshSrc, ComponentType componentType) {
     // Add a mesh to the container
 	RendObj newObj = createRendObject(meshSrc);
 	newObj.ent = ent;
 	newObj.componentType = componentType;
 
-	objects[nextObjectId] = newObj;
+	SlotMap<RendObj>::Handle handle = objects.insert(newObj);
+	if (handle == SlotMap<RendObj>::Invalid) {
+		releaseRendObject(newObj);
+		return;
+	}
+
+	RendObj *obj = objects.get(handle);
+	obj->cullProxy = cullTree.createProxy(newObj.localBounds, handle);
+
+	// Placed right away, render packets only carry the object from the next simulated frame on
+	TransformComponent *trans = getTransform(*obj);
+	refitRendObj(*obj, trans ? trans->getWorldMatrix() : mat4(1.0f), trans ? trans->getVersion() : 0);
 
 	// give the IRenderable a reference to this rendObj
-	meshSrc->rendObjId = nextObjectId++;
+	meshSrc->rendObjId = handle;
 
-	// If the entity has emission component, add it as a light source and update shaders
+	// If the entity has emission component, add it as a light source
 	IEmission* lightS = ent->getComp<EmissionComponent>()->CastType<IEmission>();
 	if (lightS != nullptr)
 	{
-		// ATM will add 0s pos
-		// Add to light arrays
-		lightSources.push_back(ent);
-		// Change the program
-		program->changeLightNum(lightSources.size());
-		// Update the program
-		updateProgram();
-
-
+		addLights(ent);
 	}
 }
 
@@ -216,20 +475,14 @@ void Renderer::addPermObject(IRenderable *mesh, ITransform *trans)
 
 void Renderer::removeObject(Entity* ent, ComponentType componentType) {
 
-    // Note: This calls the destructor on RendObj
-   // objects.erase(
-   //     std::remove_if(objects.begin(), objects.end(), 
-			//[ent, useAnimation](RendObj obj) { 
-			//		return obj.ent == ent && obj.useAnimation == useAnimation; 
-			//}),
-   //     objects.end()
-   // );
-
-	auto itr = objects.begin();
-	auto endItr = objects.end();
-	for (; itr != endItr;) {
-		if (itr->second.ent == ent && itr->second.componentType == componentType) objects.erase(itr);
-		else itr++;
+	// Removal moves the last object into the hole, so only step past objects that stay
+	u32 i = 0;
+	while (i < objects.size()) {
+		if (objects[i].ent == ent && objects[i].componentType == componentType) {
+			releaseRendObject(objects[i]);
+			objects.removeAt(i);
+		}
+		else i++;
 	}
 
     LOG_DEBUG("Renderer object count: %i\n", objects.size());
@@ -237,39 +490,21 @@ void Renderer::removeObject(Entity* ent, ComponentType componentType) {
 
 void Renderer::removeObject(u32 rendObjId) {
 
-	objects.erase(rendObjId);
-	LOG_DEBUG("Renderer object count: %i\n", objects.size());
-}
+	RendObj *obj = objects.get(rendObjId);
+	if (obj == nullptr) return;
 
-GLuint Renderer::setTexture(const String texturePath, const char* uniName, int num) {
+	releaseRendObject(*obj);
+	objects.remove(rendObjId);
 
-	GLuint tex;
-	glGenTextures(1, &tex);
-	glActiveTexture(GL_TEXTURE0 + num);
-	glBindTexture(GL_TEXTURE_2D, tex);
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	
-	int width, height, nrChannels;
-	stbi_set_flip_vertically_on_load(true); // flip loaded texture's on the y-axis.
-	unsigned char* data = stbi_load(texturePath.c_str(), &width, &height, &nrChannels, 0);
+	LOG_DEBUG("Renderer object count: %i, vertex pool %u/%u, element pool %u/%u, textures %u (%llu bytes)\n", objects.size(),
+			vertexPool->getUsed(), vertexPool->getCapacity(), elementPool->getUsed(), elementPool->getCapacity(),
+			textureCache.getTextureCount(), textureCache.getResidentBytes());
+}
 
-	if (data)
-	{
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-	}
-	else
-	{
-		LOG_DEBUG("Failed to load file %s ", texturePath.c_str());
-	}
-	stbi_image_free(data);
+GLuint Renderer::setTexture(const String texturePath, const char* uniName, int num, u32 placeholder) {
+
+	// Decoded in the background, the object draws with the placeholder colour until draw() uploads it
+	GLuint tex = textureCache.acquire(texturePath, placeholder);
 
 	GLuint textureLoc = program->getUniformLocation(uniName);
 	glProgramUniform1i(program->getProgramId(), textureLoc, num);
@@ -279,6 +514,7 @@ GLuint Renderer::setTexture(const String texturePath, const char* uniName, int n
 
 void Renderer::clearObject()
 {
+	for (RendObj &obj : objects) releaseRendObject(obj);
 	objects.clear();
 }
 
@@ -287,108 +523,534 @@ void Renderer::addLights(Entity *ent)
 {
 	if (std::find(lightSources.begin(), lightSources.end(), ent) == lightSources.end())
 	{
+		// A new entry in the light buffer, the shaders only see the new count
 		lightSources.push_back(ent);
+		lightUniforms.push_back({});
+		lightSetVersion++;
+
+		updateLightPos((u32)lightSources.size() - 1);
+		updateLightMaterial((u32)lightSources.size() - 1);
+	}
+}
+
+void Renderer::removeLight(Entity *ent)
+{
+	auto itr = std::find(lightSources.begin(), lightSources.end(), ent);
+	if (itr == lightSources.end()) return;
+
+	// Lights after the removed one move down by one, they all need uploading again
+	u32 lightInd = (u32)(itr - lightSources.begin());
+	lightSources.erase(itr);
+	lightUniforms.erase(lightUniforms.begin() + lightInd);
+	lightSetVersion++;
+
+	if (lightInd < lightUniforms.size()) {
+		markLightDirty(lightInd);
+		markLightDirty((u32)lightUniforms.size() - 1);
+	}
+}
 
-		program->changeLightNum(lightSources.size());
-		// Update the program
-		updateProgram();
+bool Renderer::isRendObjVisible(const RendObj &obj) {
+
+	// We don't want to render something that has been removed or doesn't exist
+	if (obj.ent == nullptr) return false;
+
+	Entity* ent = obj.ent;
+
+	// Skip if the entity is not enabled
+	if (!ent->isEntityEnabled()) return false;
+
+	// Renderable
+	if (obj.componentType == ComponentType::RenderableType) {
+		if (!ent->isEnabled<RenderableComponent>()) return false;
+	}
+	// AudioGeometry
+	else if (obj.componentType == ComponentType::AudioGeometryType) {
+		if (!ent->isEnabled<AudioGeometryComponent>() || !ent->getComp<AudioGeometryComponent>()->render) return false;
+	}
+	// AudioListener: only draw the active listener
+	else if (obj.componentType == ComponentType::AudioListenerType) {
+		if (!ent->isEnabled<AudioListenerComponent>() || !ent->getComp<AudioListenerComponent>()->active) return false;
 	}
+
+	return true;
+}
+
+TransformComponent* Renderer::getTransform(const RendObj &obj) const {
+
+	if (obj.ent != nullptr && obj.ent->containsComps<TransformComponent>() && obj.ent->isEnabled<TransformComponent>()) {
+		return obj.ent->getComp<TransformComponent>();
+	}
+
+	return nullptr;
+}
+
+void Renderer::refitRendObj(RendObj &obj, const mat4 &worldTransform, u32 version) {
+
+	// Nothing to do unless the transform was rebuilt or the animation changed since the last refit
+	if (version == obj.transformVersion) return;
+
+	obj.transformVersion = version;
+	obj.worldTransform = worldTransform;
+	obj.boundsTransform = worldTransform * obj.transformation;
+
+	// The tree only reinserts the proxy if it left its enlarged box
+	cullTree.moveProxy(obj.cullProxy, obj.localBounds.transformed(obj.boundsTransform));
+}
+
+bool Renderer::isRendObjOccluded(const RendObj &obj) const {
+	return useOcclusionCulling && hiZ->isOccluded(obj.localBounds.transformed(obj.boundsTransform));
+}
+
+u32 Renderer::selectLod(const RendObj &obj, const vec3 &cameraPosition, f32 pixelsPerUnit) const {
+
+	if (obj.lodCount <= 1 || lodPixelError <= 0.0f) return 0;
+
+	// Errors are in mesh units, the largest axis scale bounds how much the transform grows them
+	f32 scale = std::max(glm::length(vec3(obj.boundsTransform[0])),
+			std::max(glm::length(vec3(obj.boundsTransform[1])), glm::length(vec3(obj.boundsTransform[2]))));
+
+	// Distance to the closest point of the box, from inside it everything is full detail
+	AABB bounds = obj.localBounds.transformed(obj.boundsTransform);
+	vec3 closest = glm::clamp(cameraPosition, bounds.min, bounds.max);
+	f32 distance = glm::length(closest - cameraPosition);
+	if (distance <= 0.0f) return 0;
+
+	f32 pixelsPerError = scale * pixelsPerUnit / distance;
+
+	for (u32 lod = obj.lodCount - 1; lod > 0; lod--) {
+		if (obj.lods[lod].error * pixelsPerError <= lodPixelError) return lod;
+	}
+
+	return 0;
+}
+
+void Renderer::gatherVisibleObjects() {
+
+	u32 enabledObjects = 0;
+	u32 occludedObjects = 0;
+
+	// Pixels covered by one unit at distance one, the screen error of a level is error * this / distance
+	vec3 cameraPosition = vec3(glm::inverse(camera->getCameraTransf())[3]);
+	f32 pixelsPerUnit = renderHeight * 0.5f * projection[1][1];
+
+	for (RendObj &obj : objects) {
+		if (!isRendObjVisible(obj)) continue;
+
+		enabledObjects++;
+
+		if (useFrustumCulling) continue;
+
+		if (isRendObjOccluded(obj)) {
+			occludedObjects++;
+			continue;
+		}
+
+		obj.lod = selectLod(obj, cameraPosition, pixelsPerUnit);
+		drawList.push_back(&obj);
+	}
+
+	if (useFrustumCulling) {
+		visibleObjects.clear();
+		cullTree.query(Frustum(projection * camera->getCameraTransf()), visibleObjects);
+
+		for (u32 handle : visibleObjects) {
+			RendObj *obj = objects.get(handle);
+			if (!isRendObjVisible(*obj)) continue;
+
+			if (isRendObjOccluded(*obj)) {
+				occludedObjects++;
+				continue;
+			}
+
+			obj->lod = selectLod(*obj, cameraPosition, pixelsPerUnit);
+			drawList.push_back(obj);
+		}
+	}
+
+	renderStats.objectsOccluded = occludedObjects;
+	renderStats.objectsCulled = enabledObjects - occludedObjects - (u32)(drawList.size() - perm_objects.size());
+}
+
+// Textures actually bound for an object, 0 leaves whatever is bound alone
+static inline u32 ambientTextureOf(const RendObj &obj) { return obj.has_texture ? obj.ambientTexture : 0; }
+static inline u32 normalTextureOf(const RendObj &obj) { return obj.has_normal ? obj.normalTexture : 0; }
+
+// Indices actually drawn for an object, those of the level picked this frame
+static inline i32 lodIndexCount(const RendObj &obj) { return obj.lods[obj.lod].indexCount; }
+static inline u32 lodElementOffset(const RendObj &obj) { return obj.elementRange.offset + obj.lods[obj.lod].elementOffset; }
+
+// Consecutive objects that can go out as instances of one draw
+static bool canInstance(const RendObj *a, const RendObj *b) {
+	return a->renderType == b->renderType &&
+		a->indexType == b->indexType &&
+		lodIndexCount(*a) == lodIndexCount(*b) &&
+		lodElementOffset(*a) == lodElementOffset(*b) &&
+		a->vertexRange.offset == b->vertexRange.offset &&
+		ambientTextureOf(*a) == ambientTextureOf(*b) &&
+		normalTextureOf(*a) == normalTextureOf(*b);
 }
 
 void Renderer::draw() {
 
-	// Render
-	program->use();
+	GpuProfileScope profile("Scene");
+
+	// Textures decoded since the last frame, within the upload budget
+	textureCache.update();
+	readShadedFragments();
+	if (useOcclusionCulling) hiZ->collect();
 
 	setFrameBufferToTexture();	
     glDepthFunc(GL_LESS);
-	glBindVertexArray(VAO);
+	GLStateCache::Instance()->bindVertexArray(VAO);
 
-	for (u32 i = 0; i < perm_objects.size(); i++)
-	{
-		// If the object has a position and it's enabled, use it
-		mat4 worldMat = mat4(1.0f);
-		program->set4Matrix("toWorld", worldMat);
-		program->set4Matrix("modelMatrix", perm_objects[i].transformation);
-
-		// Activate and bind textures of the object
-		if(perm_objects[i].has_texture) {
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, perm_objects[i].ambientTexture);
-		}
+	// Gather everything drawn this frame, the index in drawList is the draw id used by the shader
+	drawList.clear();
+	objectUniforms.clear();
 
-		if(perm_objects[i].has_texture) {
-			glActiveTexture(GL_TEXTURE2);
-			glBindTexture(GL_TEXTURE_2D, perm_objects[i].normalTexture);
+	for (u32 i = 0; i < perm_objects.size(); i++) {
+		drawList.push_back(&perm_objects[i]);
+	}
+
+	gatherVisibleObjects();
+	sortDrawList();
+
+	geometryStats.frameBytes = 0;
+	geometryStats.legacyFrameBytes = 0;
+	renderStats.trianglesDrawn = 0;
+	renderStats.trianglesFullDetail = 0;
+
+	for (const RendObj *obj : drawList) {
+		objectUniforms.push_back({ obj->worldTransform, obj->transformation });
+
+		u32 indexSize = obj->indexType == GL_UNSIGNED_SHORT ? sizeof(u16) : sizeof(u32);
+		geometryStats.frameBytes += obj->vertexRange.count * sizeof(PackedVertex) + lodIndexCount(*obj) * indexSize;
+		geometryStats.legacyFrameBytes += obj->vertexRange.count * kUnpackedVertexSize + obj->indexCount * sizeof(i32);
+
+		if (obj->renderType == GL_TRIANGLES) {
+			renderStats.trianglesDrawn += lodIndexCount(*obj) / 3;
+			renderStats.trianglesFullDetail += obj->indexCount / 3;
 		}
+	}
+
+	// Lights are binned against this frame's camera, before the frame block that carries the grid parameters
+	lightClusters->build(lightUniforms, camera->getCameraTransf(), projection);
+
+	// One copy into the stream buffer for the frame block and one for all the object matrices,
+	// lights stay in their own buffer and are only uploaded if some changed
+	updateCamera();
+	StreamRange frameRange = StreamBuffer::Instance()->upload(&frameUniforms, sizeof(FrameUniforms));
+	glBindBufferRange(GL_UNIFORM_BUFFER, FrameUniformBinding, frameRange.buffer, frameRange.offset, frameRange.size);
+
+	uploadObjectUniforms();
+	uploadLights();
 
-		//if(perm_objects[i].renderType == GL_LINES) {
-		//	glLineWidth(perm_objects[i].lineWidth);
-		//}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LightBufferBinding, lightSSBO);
+	lightClusters->bind(ClusterRangeBinding, ClusterIndexBinding);
 
-		glDrawElements(perm_objects[i].renderType, (perm_objects[i].endInd - perm_objects[i].startInd), GL_UNSIGNED_INT, (void*)(perm_objects[i].startInd * sizeof(i32)));
+	auto submitStart = std::chrono::high_resolution_clock::now();
 
+	renderStats.drawCalls = 0;
+	renderStats.prepassDrawCalls = 0;
+	renderStats.objectsDrawn = (u32)drawList.size();
+	renderStats.sharedGeometries = (u32)sharedGeometry.size();
+	renderStats.lightBinningMs = lightClusters->getBinningMs();
+	renderStats.clusterLightIndices = lightClusters->getIndexCount();
 
-		//glLineWidth(1.0f);
+	// Both passes' commands go up in one upload, the pre-pass batches first
+	if (useIndirectDraw) {
+		drawCommands.clear();
+		drawBatches.clear();
+
+		if (useDepthPrepass) buildDrawBatches(prepassList, false);
+		prepassBatchCount = (u32)drawBatches.size();
+		buildDrawBatches(drawList, true);
+
+		uploadDrawCommands();
 	}
 
-	for (u32 i = 0; i < objects.size(); i++) {
+	if (useDepthPrepass) drawDepthPrepass();
+	drawMainPass();
+	drawGrid();
 
-		// We don't want to render something that has been removed or doesn't exist
-		if (objects[i].ent == nullptr)
-			continue;
+	if (useIndirectDraw) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	auto submitEnd = std::chrono::high_resolution_clock::now();
+	renderStats.submitMs = std::chrono::duration<f64, std::milli>(submitEnd - submitStart).count();
+
+	// For the frames after this one, they test against this frame's depth
+	if (useOcclusionCulling) {
+		GpuProfileScope hiZProfile("Hi-Z pyramid");
+		hiZ->build(depthStencilTexture, renderWidth, renderHeight, projection * camera->getCameraTransf());
+	}
+
+	GLStateCache::Instance()->bindVertexArray(0);
+	setFrameBufferToDefault();
+}
 
-		Entity* ent = objects[i].ent;
+void Renderer::sortDrawList() {
 
-		// Skip if the entity is not enabled
-		if (!ent->isEntityEnabled()) continue;
+	mat4 view = camera->getCameraTransf();
+	u32 programId = program->getProgramId();
 
-		// Renderable
-		if (objects[i].componentType == ComponentType::RenderableType) {
-			if (!ent->isEnabled<RenderableComponent>()) continue;
+	// Depth goes in the key as log depth between the planes of the projection
+	f32 nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+	f32 farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+	f32 logRange = std::log(farPlane / nearPlane);
+
+	// With the pre-pass the main pass only shades visible fragments whatever the order, state wins
+	bool depthFirst = useFrontToBack && !useDepthPrepass;
+
+	renderQueue.clear();
+	prepassQueue.clear();
+
+	for (u32 i = 0; i < drawList.size(); i++) {
+		const RendObj &obj = *drawList[i];
+
+		vec3 center = (obj.localBounds.min + obj.localBounds.max) * 0.5f;
+		f32 depth = -(view * obj.boundsTransform * vec4(center, 1.0f)).z;
+		f32 depth01 = std::log(std::max(depth, nearPlane) / nearPlane) / logRange;
+
+		// Objects with the same geometry share their vertex range offset, the level goes in its own low bits
+		// so only objects drawing the same level of it end up together
+		static_assert(kMaxLodLevels <= 4, "The LOD level has two bits of the geometry key field");
+		u32 indexType = obj.indexType == GL_UNSIGNED_INT;
+		u32 geometry = (obj.vertexRange.offset << 2) | obj.lod;
+		if (depthFirst) {
+			renderQueue.push(RenderQueue::makeDepthKey(obj.renderType, indexType,
+						ambientTextureOf(obj), normalTextureOf(obj), geometry, depth01), i);
+		} else {
+			renderQueue.push(RenderQueue::makeKey(programId, obj.renderType, indexType,
+						ambientTextureOf(obj), normalTextureOf(obj), geometry, depth01), i);
 		}
-		// AudioGeometry
-		else if (objects[i].componentType == ComponentType::AudioGeometryType) {
-			if (!ent->isEnabled<AudioGeometryComponent>() || !ent->getComp<AudioGeometryComponent>()->render) continue;
+
+		// The pre-pass binds no textures, only the geometry is kept together for instancing
+		if (useDepthPrepass) {
+			prepassQueue.push(RenderQueue::makeDepthKey(obj.renderType, indexType, 0, 0, geometry, depth01), i);
 		}
-		// AudioListener: only draw the active listener
-		else if (objects[i].componentType == ComponentType::AudioListenerType) {
-			if (!ent->isEnabled<AudioListenerComponent>() || !ent->getComp<AudioListenerComponent>()->active) continue;
+	}
+
+	renderQueue.sort();
+
+	sortedDrawList.clear();
+	for (const RenderItem &item : renderQueue.getItems()) sortedDrawList.push_back(drawList[item.index]);
+	drawList.swap(sortedDrawList);
+
+	if (!useDepthPrepass) return;
+
+	prepassQueue.sort();
+
+	// sortedDrawList holds the unsorted order now
+	const Array<RenderItem> &sorted = renderQueue.getItems();
+	drawListPosition.resize(sorted.size());
+	for (u32 i = 0; i < sorted.size(); i++) drawListPosition[sorted[i].index] = i;
+
+	prepassList.clear();
+	prepassDrawIds.clear();
+	for (const RenderItem &item : prepassQueue.getItems()) {
+		prepassList.push_back(sortedDrawList[item.index]);
+		prepassDrawIds.push_back(drawListPosition[item.index]);
+	}
+}
+
+void Renderer::bindRendObjTextures(u32 ambientTexture, u32 normalTexture) {
+
+	// Bind textures of the object, the cache drops binds of what is already there
+	GLStateCache *state = GLStateCache::Instance();
+	if (ambientTexture != 0) state->bindTexture(1, ambientTexture);
+	if (normalTexture != 0) state->bindTexture(2, normalTexture);
+}
+
+void Renderer::drawDirect(const Array<const RendObj*> &list, bool withTextures) {
+
+	for (u32 i = 0; i < list.size();) {
+		const RendObj &obj = *list[i];
+
+		// Objects sharing geometry and textures are next to each other after sorting
+		u32 instanceCount = 1;
+		while (i + instanceCount < list.size() && canInstance(list[i], list[i + instanceCount])) instanceCount++;
+
+		if (withTextures) bindRendObjTextures(ambientTextureOf(obj), normalTextureOf(obj));
+		drawRendObj(obj, i, instanceCount);
+
+		renderStats.drawCalls++;
+		i += instanceCount;
+	}
+}
+
+void Renderer::buildDrawBatches(const Array<const RendObj*> &list, bool withTextures) {
+
+	u32 firstBatch = (u32)drawBatches.size();
+
+	// The list is sorted, so every change of state starts a new batch
+	for (u32 i = 0; i < list.size(); i++) {
+		const RendObj &obj = *list[i];
+
+		u32 indexSize = obj.indexType == GL_UNSIGNED_SHORT ? sizeof(u16) : sizeof(u32);
+		u32 ambientTexture = withTextures ? ambientTextureOf(obj) : 0;
+		u32 normalTexture = withTextures ? normalTextureOf(obj) : 0;
+
+		if (drawBatches.size() == firstBatch ||
+			drawBatches.back().renderType != obj.renderType ||
+			drawBatches.back().indexType != obj.indexType ||
+			drawBatches.back().ambientTexture != ambientTexture ||
+			drawBatches.back().normalTexture != normalTexture)
+		{
+			drawBatches.push_back({ obj.renderType, obj.indexType, ambientTexture, normalTexture, (u32)drawCommands.size(), 0 });
 		}
 
-		// If the object has a transform and it's enabled, use it
-		glm::mat4 worldMat = glm::mat4(1.0f);
-		if (objects[i].ent->containsComps<TransformComponent>() && objects[i].ent->isEnabled<TransformComponent>()) {
-			ITransform* pos = objects[i].ent->getComp<TransformComponent>()->CastType<ITransform>();
-			glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(pos->x, pos->y, pos->z));
-			glm::mat4 rotation = glm::eulerAngleXYZ(pos->rx, pos->ry, pos->rz);
-			glm::mat4 scale = glm::scale(glm::mat4(1.0f), glm::vec3(pos->sx, pos->sy, pos->sz));
-			worldMat = translation * rotation * scale;
+		// Same geometry as the previous object in this batch, draw it as one more instance.
+		// Draw ids are consecutive so baseInstance + instance still points at the right entry
+		if (drawBatches.back().commandCount > 0 && canInstance(list[i - 1], &obj)) {
+			drawCommands.back().instanceCount++;
+			continue;
 		}
 
-		program->set4Matrix("toWorld", worldMat);
-        program->set4Matrix("modelMatrix", objects[i].transformation);
+		// firstIndex is in indices, element ranges are 4 byte aligned so this divides exactly
+		drawCommands.push_back({ (u32)lodIndexCount(obj), 1, lodElementOffset(obj) / indexSize, (i32)obj.vertexRange.offset, i });
+		drawBatches.back().commandCount++;
+	}
+}
 
-        // Activate and bind textures of the object
-		if(objects[i].has_texture) {
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, objects[i].ambientTexture);
-		} 
+void Renderer::uploadDrawCommands() {
 
-		if(objects[i].has_normal) {
-			glActiveTexture(GL_TEXTURE2);
-			glBindTexture(GL_TEXTURE_2D, objects[i].normalTexture);
-		}
+	u32 count = (u32)drawCommands.size();
+	if (count == 0) return;
+
+	StreamRange range = StreamBuffer::Instance()->upload(drawCommands.data(), count * sizeof(DrawElementsIndirectCommand));
+	indirectOffset = range.offset;
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, range.buffer);
+}
+
+void Renderer::drawIndirect(u32 firstBatch, u32 endBatch) {
 
-		// Draw the object
-		glDrawElements(objects[i].renderType, (objects[i].endInd - objects[i].startInd), GL_UNSIGNED_INT, (void*)(objects[i].startInd * sizeof(i32)));
-		// glDrawArrays(GL_TRIANGLES, 0, 3);
+	for (u32 i = firstBatch; i < endBatch; i++) {
+		const DrawBatch &batch = drawBatches[i];
+
+		bindRendObjTextures(batch.ambientTexture, batch.normalTexture);
+
+		glMultiDrawElementsIndirect(batch.renderType, batch.indexType,
+				(void*)(uptr)(indirectOffset + batch.firstCommand * sizeof(DrawElementsIndirectCommand)),
+				batch.commandCount, sizeof(DrawElementsIndirectCommand));
+
+		renderStats.drawCalls++;
 	}
+}
 
+void Renderer::drawDepthPrepass() {
 
-	
-	glBindVertexArray(0);
-	setFrameBufferToDefault();
+	GpuProfileScope profile("Depth pre-pass");
+
+	// Instance k of the pre-pass reads its draw id from prepassDrawIds[k]
+	StreamRange ids = StreamBuffer::Instance()->upload(prepassDrawIds.data(), (u32)prepassDrawIds.size() * sizeof(u32));
+	glVertexArrayVertexBuffer(VAO, 1, ids.buffer, ids.offset, sizeof(u32));
+
+	depthProgram->use();
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	u32 drawCalls = renderStats.drawCalls;
+	if (useIndirectDraw) drawIndirect(0, prepassBatchCount);
+	else drawDirect(prepassList, false);
+	renderStats.prepassDrawCalls = renderStats.drawCalls - drawCalls;
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glVertexArrayVertexBuffer(VAO, 1, drawIdBuffer, 0, sizeof(u32));
+}
+
+void Renderer::drawMainPass() {
+
+	if (showOverdraw) {
+		// Every fragment that gets shaded adds one step, starting from black
+		overdrawProgram->use();
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+	} else {
+		program->use();
+	}
+
+	// The depth buffer already holds the nearest surface, only fragments on it pass
+	if (useDepthPrepass) {
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	bool countShaded = !shadedQueryPending;
+	if (countShaded) glBeginQuery(GL_SAMPLES_PASSED, shadedQuery);
+
+	if (useIndirectDraw) drawIndirect(prepassBatchCount, (u32)drawBatches.size());
+	else drawDirect(drawList, true);
+
+	if (countShaded) {
+		glEndQuery(GL_SAMPLES_PASSED);
+		shadedQueryPending = true;
+	}
+
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+}
+
+void Renderer::drawGrid() {
+
+	if (!showGrid || showOverdraw) return;
+
+	GpuProfileScope profile("Grid");
+
+	// Blended over the opaque scene, tested against its depth but never writing any
+	gridProgram->use();
+	gridProgram->setFloat("gridSpacing", gridSpacing);
+	gridProgram->setFloat("fadeDistance", gridFadeDistance);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+
+	GLStateCache *state = GLStateCache::Instance();
+	state->bindVertexArray(upscaleVAO);
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	state->bindVertexArray(VAO);
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+}
+
+void Renderer::readShadedFragments() {
+
+	if (!shadedQueryPending) return;
+
+	// Never waits, the count just stays at the last one until the GPU gets there
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(shadedQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available != GL_TRUE) return;
+
+	GLuint64 samples = 0;
+	glGetQueryObjectui64v(shadedQuery, GL_QUERY_RESULT, &samples);
+	renderStats.shadedPerPixel = samples / (f64)(renderWidth * renderHeight);
+	shadedQueryPending = false;
+}
+
+void Renderer::drawRendObj(const RendObj &obj, u32 drawId, u32 instanceCount) {
+
+	// The base instance offsets the instanced draw id attribute to the first object's entry
+	glDrawElementsInstancedBaseVertexBaseInstance(obj.renderType, lodIndexCount(obj), obj.indexType,
+			(void*)(uptr)lodElementOffset(obj), instanceCount, (i32)obj.vertexRange.offset, drawId);
+}
+
+void Renderer::logGeometryStats() {
+
+	const GeometryStats &stats = geometryStats;
+	// The old layout had no LODs, they are left out of the ratio so it compares the same data
+	u64 fullDetailBytes = stats.residentBytes - stats.lodBytes;
+	f64 ratio = fullDetailBytes > 0 ? (f64)stats.legacyResidentBytes / (f64)fullDetailBytes : 0.0;
+
+	LOG_DEBUG("Geometry: %llu vertices, %llu indices, %.2f MB resident with %.2f MB of LOD indices (%.2f MB unpacked, %.2fx smaller without LODs), last frame fetched %.2f MB (%.2f MB unpacked)",
+			stats.vertices, stats.indices,
+			stats.residentBytes / (1024.0 * 1024.0), stats.lodBytes / (1024.0 * 1024.0), stats.legacyResidentBytes / (1024.0 * 1024.0), ratio,
+			stats.frameBytes / (1024.0 * 1024.0), stats.legacyFrameBytes / (1024.0 * 1024.0));
+
+	LOG_DEBUG("Textures: %u resident, %.2f MB", textureCache.getTextureCount(), textureCache.getResidentBytes() / (1024.0 * 1024.0));
 }
 
 void Renderer::fillBackground(f32 r, f32 g, f32 b) {
@@ -417,94 +1079,88 @@ void Renderer::fillBackground(i32 hex) {
 void Renderer::updateProjection(i32 width, i32 height) {
 	w = width;
 	h = height;
-	projection = glm::perspective(glm::radians(45.0f), (GLfloat)width / (GLfloat)height, 0.1f, 10000.0f);
-	program->set4Matrix("toProjection", projection);
+	projection = glm::perspective(glm::radians(kFieldOfView), (GLfloat)width / (GLfloat)height, kNearPlane, kFarPlane);
 }
 
-void Renderer::createVertexArray(IRenderable* mesh)
+void Renderer::createVertexArray(IRenderable* mesh, PoolRange range)
 {
-	numberOfVertices += mesh->getNumOfVertices();
-		const auto v = mesh->getVertices();
-    copy(v.begin(), v.end(), back_inserter(vertices));
-}
+	const auto &meshVertices = mesh->getVertices();
+	const auto &meshNormals = mesh->getNormals();
+	const auto &meshTexCoords = mesh->getTexCoords();
+
+	bool hasNormals = mesh->has_normal && meshNormals.size() >= range.count;
+	bool hasTexCoords = mesh->has_texture && meshTexCoords.size() >= range.count;
+
+	Array<PackedVertex> packed(range.count);
+	for (u32 i = 0; i < range.count; i++) {
+		packed[i] = packVertex(
+			meshVertices[i],
+			hasNormals ? meshNormals[i] : vec3(0.0f),
+			hasTexCoords ? meshTexCoords[i] : vec2(0.0f)
+		);
+	}
 
-void Renderer::createTexCoordArray(IRenderable* mesh)
-{
-	numOfTexCoords += mesh->getNumOfTexCoord();
-    const auto meshTexCoords = mesh->getTexCoords();
-    copy(meshTexCoords.begin(), meshTexCoords.end(), back_inserter(texCoords));
+	vertexPool->upload(0, range, packed.data());
 }
 
-void Renderer::createNormalsArray(IRenderable* mesh)
-{
-	numberOfNormals += mesh->getNumOfNormals();
-	const auto meshNormals = mesh->getNormals();
-    copy(meshNormals.begin(), meshNormals.end(), back_inserter(normals));
-}
+// Copy the faces or indices of the mesh into the index type picked for the object
+template<typename T>
+static void fillElements(IRenderable* mesh, Array<u8> &bytes) {
 
-void Renderer::createElementArray(IRenderable* mesh)
-{
-
-	int vert_shift = (numberOfVertices - mesh->getNumOfVertices());
-	int el_shift   =  numberOfElements;
+	T* elements = (T*)bytes.data();
 
 	if(mesh->use_indices ) {
-		
-		const auto indices = mesh->getIndices();
-		numberOfElements += (i32)indices.size();
-
-		i32 *data = elements.data();
-
-		copy(indices.begin(), indices.end(), back_inserter(elements));
-
+		const auto &indices = mesh->getIndices();
+		for (u32 i = 0; i < indices.size(); i++) elements[i] = (T)indices[i];
 	} else {
 		// REMEMBER TO MULTIPLY BY 3 !!!
 		// Steven: This line is causing problem as the number of elements is not the same as
 		// number of faces.
-		numberOfElements += mesh->getNumOfFaces() * 3;
-		const auto faces = mesh->getFaces();
-		for(i32 i = 0; i < faces.size(); i++) {
-			elements.push_back(faces[i][0]);
-			elements.push_back(faces[i][1]);
-			elements.push_back(faces[i][2]);
+		const auto &faces = mesh->getFaces();
+		for(u32 i = 0; i < faces.size(); i++) {
+			elements[i*3 + 0] = (T)faces[i][0];
+			elements[i*3 + 1] = (T)faces[i][1];
+			elements[i*3 + 2] = (T)faces[i][2];
 		}
 	}
+}
 
-    for (u32 i = el_shift; i < elements.size(); i++)
-    {
-        elements[i] += vert_shift;
-    }
+template<typename T>
+static void fillLodElements(const Array<i32> &indices, u8 *start) {
 
+	T* elements = (T*)start;
+	for (u32 i = 0; i < indices.size(); i++) elements[i] = (T)indices[i];
 }
 
-void Renderer::createTangents(IRenderable* mesh)
+void Renderer::createElementArray(IRenderable* mesh, const RendObj &obj)
 {
-
-    Array<vec3> v = mesh->getVertices();
-    Array<vec2> tc = mesh->getTexCoords();
-    Array<vec3> n = mesh->getNormals();
-    Array<ivec3> elem = mesh->getFaces();
-
-
-	if(mesh->use_indices)
-	{
-		Array<vec3> newTangents(mesh->getNumOfVertices());
-		copy(newTangents.begin(), newTangents.end(), back_inserter(tangents));
-		numOfTangents += (i32)newTangents.size();
-
-		return;
+	// Sized to the whole range so the alignment padding is uploaded as zeros
+	Array<u8> bytes(obj.elementRange.count, 0);
+
+	if (obj.indexType == GL_UNSIGNED_SHORT) fillElements<u16>(mesh, bytes);
+	else fillElements<u32>(mesh, bytes);
+
+	// The coarser levels at the offsets createRendObject laid out
+	const Array<LodLevel> &levels = mesh->getLods();
+	for (u32 lod = 1; lod < obj.lodCount; lod++) {
+		u8 *start = bytes.data() + obj.lods[lod].elementOffset;
+		if (obj.indexType == GL_UNSIGNED_SHORT) fillLodElements<u16>(levels[lod - 1].indices, start);
+		else fillLodElements<u32>(levels[lod - 1].indices, start);
 	}
 
+	elementPool->upload(0, obj.elementRange, bytes.data());
+}
+
+Array<vec3> Renderer::createTangents(IRenderable* mesh)
+{
 
-    i32 i = (i32) v[elem[0][0]].x;
+    const Array<vec3> &v = mesh->getVertices();
+    const Array<vec2> &tc = mesh->getTexCoords();
+    const Array<ivec3> &elem = mesh->getFaces();
 
-    Array<vec3> newTangents(mesh->getNumOfVertices());
+    Array<vec3> newTangents(v.size(), vec3(0.0f));
 
-    for (auto itr = newTangents.begin(); itr != newTangents.end(); ++itr) {
-		itr->r = 0;
-		itr->b = 0;
-		itr->g = 0;
-	}
+	if(mesh->use_indices) return newTangents;
 
     // For each triangle in the mesh
     for (int i = 0; i < elem.size(); i++)
@@ -544,9 +1200,7 @@ void Renderer::createTangents(IRenderable* mesh)
 
     // Once all of the tangents have been calculated, some would have summed tangents.
     // Devide by the number of triangles the vertice is the part of to find the average
-    std::vector<int> verticeTrianglesCount;
-    verticeTrianglesCount.resize(mesh->getNumOfVertices());
-    for (auto itr = verticeTrianglesCount.begin(); itr != verticeTrianglesCount.end(); ++itr) *itr = 0;
+    std::vector<int> verticeTrianglesCount(v.size(), 0);
 
     for (int i = 0; i < elem.size(); i++)
     {
@@ -557,39 +1211,37 @@ void Renderer::createTangents(IRenderable* mesh)
 
     for (int i = 0; i < newTangents.size(); i++)
     {
-        newTangents[i] /= verticeTrianglesCount[i];
+        if (verticeTrianglesCount[i] > 0) newTangents[i] /= verticeTrianglesCount[i];
     }
 
-    // Add calculated tangents to the container
-    copy(newTangents.begin(), newTangents.end(), back_inserter(tangents));
-    numOfTangents += (i32)newTangents.size();
+    return newTangents;
 }
 
 void Renderer::updateCamera()
 {
-    program->set4Matrix("toCamera", camera->getCameraTransf());
+	frameUniforms.toCamera = camera->getCameraTransf();
+	frameUniforms.toProjection = projection;
+	frameUniforms.cameraPosition = vec4(camera->GetCameraPosition(), 1.0f);
+	frameUniforms.clusterDepth = lightClusters->getDepthParams();
+	frameUniforms.clusterGrid = glm::uvec4(LightClusters::GridX, LightClusters::GridY, LightClusters::GridZ, 0);
+	frameUniforms.viewportSize = vec4((f32)renderWidth, (f32)renderHeight, 0.0f, 0.0f);
 }
 
 void Renderer::updateCamera(Camera* cam)
 {
     camera = cam;
-    program->set4Matrix("toCamera", camera->getCameraTransf());
+	updateCamera();
 }
 
 void Renderer::updateProgram()
 {
 	program->use();
 	// Set up Projection matrix
-    projection = glm::perspective(glm::radians(45.0f), (GLfloat)w / (GLfloat)h, 0.1f, 1000.0f);
-	program->set4Matrix("toProjection", projection);
+	updateProjection(w, h);
 
+	// Camera, projection and object matrices live in buffers shared by every program
 	updateCamera();
 
-    program->set3Float("cameraPosition", camera->GetCameraPosition());
-	// Default transformation matrices
-    program->set4Matrix("toWorld", mat4(1.0f));
-    program->set4Matrix("modelMatrix", mat4(1.0f));
-
 	updateBuffers();
 
 	// Load textures
@@ -599,60 +1251,125 @@ void Renderer::updateProgram()
 	textureLoc = program->getUniformLocation("NormTexture");
 	glUniform1i(textureLoc, 2);
 
-	// Update lights
-	for (int i = 0; i < lightSources.size(); i++)
-	{
-		updateLightPos(i);
-	}
-
 }
 
 void Renderer::updateLightPos(u32 lightInd) 
 {
-	if (lightSources.size() - 1 < lightInd)
+	if (lightInd >= lightSources.size())
 		return;
 
 	// Get position 
 	ITransform* pos = lightSources[lightInd]->getComp<TransformComponent>();
+	if (pos == nullptr) return;
 
-	// Get the light position
-	String attr = std::format("lightPosition[{}].tanPos", lightInd);
+	setLightPosition(lightInd, vec3(pos->get_x(), pos->get_y(), pos->get_z()));
+}
 
-	program->use();
-	program->set3Float(attr, pos->get_x(), pos->get_y(), -pos->get_z());
+void Renderer::setLightPosition(u32 lightInd, const vec3 &worldPosition)
+{
+	// World position so lights can be binned, w holds the range set by updateLightMaterial
+	vec4 position = vec4(worldPosition, lightUniforms[lightInd].position.w);
+	if (lightUniforms[lightInd].position == position) return;
+
+	lightUniforms[lightInd].position = position;
+	markLightDirty(lightInd);
+}
+
+void Renderer::updateLightMaterial(u32 lightInd)
+{
+	if (lightInd >= lightSources.size())
+		return;
+
+	IEmission* emission = lightSources[lightInd]->getComp<EmissionComponent>();
+	if (emission == nullptr) return;
+
+	lightUniforms[lightInd].position.w = emission->get_range();
+	lightUniforms[lightInd].diffuse = vec4(emission->get_diffuse(), 1.0f);
+	lightUniforms[lightInd].specular = vec4(emission->get_specular(), 1.0f);
+	markLightDirty(lightInd);
 }
 
 void Renderer::updateObjectTransformation(mat4 transformation, u32 rendObjId) {
 
-	const auto obj = objects.find(rendObjId);
-	if (obj != objects.end()) {
-		obj->second.transformation = transformation;
+	RendObj *obj = objects.get(rendObjId);
+	if (obj != nullptr && obj->transformation != transformation) {
+		obj->transformation = transformation;
+		obj->transformVersion = StaleTransform;
+	}
+}
+
+void Renderer::recordRenderPacket(RenderPacket &packet) const {
+
+	packet.transforms.clear();
+	packet.animations.clear();
+	packet.lightPositions.clear();
+
+	for (u32 i = 0; i < objects.size(); i++) {
+		const RendObj &obj = objects[i];
+		u32 handle = objects.handleAt(i);
+
+		TransformComponent *trans = getTransform(obj);
+		if (trans) packet.transforms.push_back({ handle, trans->getVersion(), trans->getWorldMatrix() });
+		else packet.transforms.push_back({ handle, 0, mat4(1.0f) });
+
+		if (obj.componentType == ComponentType::RenderableType && obj.ent->containsComps<AnimationComponent>()) {
+			packet.animations.push_back({ handle, obj.ent->getComp<AnimationComponent>()->getTransformation() });
+		}
+	}
+
+	packet.lightSetVersion = lightSetVersion;
+	for (Entity *light : lightSources) {
+		TransformComponent *trans = light->getComp<TransformComponent>();
+		packet.lightPositions.push_back(trans ? vec4(trans->x, trans->y, trans->z, 1.0f) : vec4(0.0f));
+	}
+}
+
+void Renderer::applyRenderPacket(const RenderPacket &packet) {
+
+	// Objects removed after the packet was recorded don't resolve anymore, ones added since keep the
+	// placement addObject gave them
+	for (const PacketAnimation &animation : packet.animations) {
+		updateObjectTransformation(animation.transformation, animation.handle);
+	}
+
+	for (const PacketTransform &transform : packet.transforms) {
+		RendObj *obj = objects.get(transform.handle);
+		if (obj != nullptr) refitRendObj(*obj, transform.worldTransform, transform.version);
+	}
+
+	// A light added or removed since reshuffled the indices, the next packet has them right
+	if (packet.lightSetVersion != lightSetVersion) return;
+
+	for (u32 i = 0; i < packet.lightPositions.size(); i++) {
+		if (packet.lightPositions[i].w != 0.0f) setLightPosition(i, vec3(packet.lightPositions[i]));
 	}
 }
 
 void Renderer::changeTexture(Entity* ent)
 {
-	for (u32 i = 0; i < objects.size(); i++)
+	for (RendObj &obj : objects)
 	{
-		if (objects[i].ent == ent)
-		{
-			RenderableComponent* rendComp = objects[i].ent->getComp<RenderableComponent>();
-			//rendComp->getAmbientTexture() doesn't return anything here atm, dunno why
-			//objects[i].ambientTexture = setTexture(rendComp->ambientTexture, "AmbTexture", 1);
-			objects[i].ambientTexture = setTexture(rendComp->getAmbientTexture(), "AmbTexture", 1);
-			objects[i].ambientTexturePath = rendComp->getAmbientTexture();
-			objects[i].normalTexturePath = rendComp->getNormalTexture();
-
-			// Reset texture path for RenderableComponent as other object may use the same reference
-			rendComp->ambientTexture = "";
-			rendComp->normalTexture = "";
-		}
+		if (obj.ent != ent) continue;
+
+		RenderableComponent* rendComp = obj.ent->getComp<RenderableComponent>();
+
+		// Take the new texture before dropping the old one, picking the same file again doesn't reload it
+		GLuint oldTexture = obj.ambientTexture;
+		obj.ambientTexture = setTexture(rendComp->getAmbientTexture(), "AmbTexture", 1);
+		if (oldTexture != 0) textureCache.release(oldTexture);
+
+		obj.ambientTexturePath = rendComp->getAmbientTexture();
+		obj.normalTexturePath = rendComp->getNormalTexture();
+
+		// Reset texture path for RenderableComponent as other object may use the same reference
+		rendComp->ambientTexture = "";
+		rendComp->normalTexture = "";
 	}
 }
 
 bool Renderer::hasRendObj(u32 id)
 {
-	return objects.find(id) != objects.end();
+	return objects.contains(id);
 }
 
 void Renderer::setupSkybox() {
@@ -756,6 +1473,8 @@ void Renderer::liveReloadFile(const char *file, LiveReloadEntry *entry) {
 			entry->changed = 0;
 		}
 
+		GLStateCache::Instance()->invalidate();
+
 	}
 }
 
@@ -792,10 +1511,13 @@ void Renderer::skyboxLoadTexture()
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+	GLStateCache::Instance()->invalidate();
 }
 
 void Renderer::drawSkyBox()
 {
+	GpuProfileScope profile("Skybox");
+
     // draw scene
     glm::mat4 view = camera->getCameraTransf();;
 
@@ -810,14 +1532,14 @@ void Renderer::drawSkyBox()
     glDepthFunc(GL_LEQUAL);
     glDisable(GL_CULL_FACE);
 
-    glBindVertexArray(skyVAO);
+    GLStateCache *state = GLStateCache::Instance();
+    state->bindVertexArray(skyVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, skyVBO);
 
     glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
-    // glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    state->bindTexture(0, cubemapTexture);
 
     program->set4Matrix("view", view);
     program->set4Matrix("projection", projection);
@@ -828,7 +1550,7 @@ void Renderer::drawSkyBox()
 	glDepthFunc(GL_LESS);
     glDepthMask(GL_TRUE);
 
-    glBindVertexArray(0);
+    state->bindVertexArray(0);
 
 }
 
@@ -860,11 +1582,52 @@ void Renderer::updateTextureSizes(u32 width, u32 height) {
 		LOG_DEBUG("Troubles with creating a framebuffer");
 	}
 
+	// Same id on every resize, the GUI may hold it from before
+	glBindTexture(GL_TEXTURE_2D, outputTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, outputTexture, 0);
+
 	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::Instance()->invalidate();
+
+	setRenderScale(renderScale);
 
 	glViewport(0, 0, width, height);
 }
 
+void Renderer::setRenderScale(f32 scale) {
+	renderScale = std::clamp(scale, 0.1f, 1.0f);
+	renderWidth = std::max((u32)std::lround(w * renderScale), 1u);
+	renderHeight = std::max((u32)std::lround(h * renderScale), 1u);
+}
+
+void Renderer::updateRenderScale(f64 frameMs) {
+	setRenderScale(dynamicResolution.update(frameMs));
+}
+
+void Renderer::upscaleScene() {
+
+	if (!isUpscaling()) return;
+
+	GpuProfileScope profile("Upscale");
+
+	// Texel size is of the whole scene texture, that's what the shader's coordinates are in
+	upscaler->setOutput(outputFBO, outputTexture, w, h);
+	upscaler->set4Float("sourceScale", renderWidth / (f32)w, renderHeight / (f32)h, 1.0f / w, 1.0f / h);
+	upscaler->setFloat("sharpness", upscaleSharpness);
+
+	Array<u32> inputs = { textureToRenderTo };
+
+	GLStateCache *state = GLStateCache::Instance();
+	state->bindVertexArray(upscaleVAO);
+	upscaler->draw(0.0, inputs);
+	state->bindVertexArray(0);
+}
+
 const char* Renderer::getSkyboxImagePath(u32 skyboxPosition) {
 	// positions are in this order: +x, -x, +y, -y, +z, -z
 	return skyboxImages[skyboxPosition].c_str();
@@ -898,5 +1661,6 @@ void Renderer::setSkyboxImage(const String& image_path, u32 skyboxPosition) {
 		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
 	}
-	
+
+	GLStateCache::Instance()->invalidate();
 }
@@ -6,6 +6,8 @@
 #include <Components/EmissionComponent.h>
 #include <Core/Entity.h>
 
+#include <random>
+
 using namespace NoxEngine;
 using namespace NoxEngineGUI;
 
@@ -63,3 +65,26 @@ void Scene::addEntity(PresetObject obj) {
 	}
 	this->addEntity(ent);
 }
+
+void Scene::addPointLights(u32 count, const vec3 &min, const vec3 &max, f32 range) {
+
+	// Fixed seed so runs can be compared
+	std::mt19937 random(1337);
+	std::uniform_real_distribution<f32> unit(0.0f, 1.0f);
+
+	for (u32 i = 0; i < count; i++) {
+		vec3 position = min + (max - min) * vec3(unit(random), unit(random), unit(random));
+		vec3 color = vec3(unit(random), unit(random), unit(random));
+
+		String name = "Point Light " + std::to_string(i);
+		Entity* ent = new Entity(this, name.c_str());
+
+		EmissionComponent* em = new EmissionComponent(color, color, color);
+		em->set_range(range);
+
+		ent->addComp<TransformComponent>(new TransformComponent(position.x, position.y, position.z));
+		ent->addComp<EmissionComponent>(em);
+
+		this->addEntity(ent);
+	}
+}
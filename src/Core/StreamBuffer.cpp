@@ -0,0 +1,129 @@
+#include <Core/StreamBuffer.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace NoxEngine;
+
+static const GLbitfield StreamMapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+StreamBuffer::StreamBuffer() :
+	_buffer(0),
+	_mapped(nullptr),
+	_frameCapacity(0),
+	_region(0),
+	_offset(0),
+	_fences(),
+	_retired(),
+	_alignment(16),
+	_stats()
+{
+	GLint uniformAlignment = 0;
+	GLint storageAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+	_alignment = std::max({ _alignment, (u32)uniformAlignment, (u32)storageAlignment });
+
+	create(InitialFrameCapacity);
+}
+
+StreamBuffer::~StreamBuffer() {
+	for (GLsync &fence : _fences) {
+		if (fence != 0) glDeleteSync(fence);
+	}
+
+	glDeleteBuffers((GLsizei)_retired.size(), _retired.data());
+	glDeleteBuffers(1, &_buffer);
+}
+
+void StreamBuffer::create(u32 frameCapacity) {
+
+	_frameCapacity = frameCapacity;
+	_stats.frameCapacity = frameCapacity;
+
+	glCreateBuffers(1, &_buffer);
+	glNamedBufferStorage(_buffer, (GLsizeiptr)frameCapacity * FrameCount, NULL, StreamMapFlags);
+	_mapped = (u8*)glMapNamedBufferRange(_buffer, 0, (GLsizeiptr)frameCapacity * FrameCount, StreamMapFlags);
+
+	if (_mapped == nullptr) LOG_DEBUG("Failed to map a %u byte stream buffer", frameCapacity * FrameCount);
+}
+
+void StreamBuffer::nextFrame() {
+
+	// Everything submitted since the last call read from the current region
+	if (_fences[_region] != 0) glDeleteSync(_fences[_region]);
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	// Deleting unmaps them, storage the GPU still reads stays until it's done
+	if (!_retired.empty()) {
+		glDeleteBuffers((GLsizei)_retired.size(), _retired.data());
+		_retired.clear();
+	}
+
+	_stats.lastFrameBytes = _offset;
+	_stats.peakFrameBytes = std::max(_stats.peakFrameBytes, _offset);
+	_stats.waitMs = 0.0;
+
+	_region = (_region + 1) % FrameCount;
+	_offset = 0;
+
+	GLsync fence = _fences[_region];
+	if (fence == 0) return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// Flush on the first try so the fence is sure to be signalled eventually
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true) {
+		GLenum result = glClientWaitSync(fence, flags, 1000000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) break;
+		if (result == GL_WAIT_FAILED) {
+			LOG_DEBUG("Waiting for a stream buffer fence failed");
+			break;
+		}
+		flags = 0;
+	}
+
+	_stats.waitMs = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	glDeleteSync(fence);
+	_fences[_region] = 0;
+}
+
+StreamRange StreamBuffer::allocate(u32 bytes, u32 alignment) {
+
+	if (alignment == 0) alignment = _alignment;
+
+	u32 offset = (_offset + alignment - 1) / alignment * alignment;
+
+	if (offset + bytes > _frameCapacity) {
+		// The regions of the old buffer aren't reused, so its fences don't matter anymore
+		for (GLsync &fence : _fences) {
+			if (fence != 0) glDeleteSync(fence);
+			fence = 0;
+		}
+
+		_retired.push_back(_buffer);
+		create(std::max(_frameCapacity * 2, bytes + alignment));
+		_stats.grows++;
+
+		LOG_DEBUG("Stream buffer grown to %u bytes per frame", _frameCapacity);
+
+		offset = 0;
+	}
+
+	_offset = offset + bytes;
+
+	u32 bufferOffset = _region * _frameCapacity + offset;
+	return { _buffer, bufferOffset, bytes, _mapped + bufferOffset };
+}
+
+StreamRange StreamBuffer::upload(const void *data, u32 bytes, u32 alignment) {
+
+	StreamRange range = allocate(bytes, alignment);
+	if (bytes > 0) memcpy(range.data, data, bytes);
+
+	return range;
+}
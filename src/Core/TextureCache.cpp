@@ -0,0 +1,281 @@
+#include <Core/TextureCache.h>
+#include <Core/GLStateCache.h>
+#include <Utils/Utils.h>
+
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include <3rdParty/stb/stb_image.h>
+
+using namespace NoxEngine;
+
+// Pixel unpack buffers in flight, an upload waits for its slot's previous upload to be consumed
+static const u32 kPixelBufferCount = 3;
+// Bytes copied into a pixel buffer between two budget checks
+static const u64 kStageChunkBytes = 256 * 1024;
+
+// stb's flip flag is global and the skybox loads with it off, so the workers flip the rows themselves
+static void flipRows(u8 *pixels, i32 width, i32 height, i32 channels) {
+	u64 rowSize = (u64)width * channels;
+	Array<u8> row(rowSize);
+
+	for (i32 y = 0; y < height / 2; y++) {
+		u8 *top = pixels + y * rowSize;
+		u8 *bottom = pixels + (height - 1 - y) * rowSize;
+		memcpy(row.data(), top, rowSize);
+		memcpy(top, bottom, rowSize);
+		memcpy(bottom, row.data(), rowSize);
+	}
+}
+
+static f64 elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+TextureCache::TextureCache() :
+	_entries(),
+	_paths(),
+	_residentBytes(0),
+	_pendingCount(0),
+	_uploadBudgetMs(2.0),
+	_pixelBuffers(),
+	_nextPixelBuffer(0),
+	_uploads(),
+	_decodedMutex(),
+	_decoded(),
+	_workers()
+{ }
+
+TextureCache::~TextureCache() {
+
+	_workers.shutdown();
+
+	for (DecodedImage &image : _decoded) stbi_image_free(image.pixels);
+	for (DecodedImage &image : _uploads) stbi_image_free(image.pixels);
+
+	for (PixelBuffer &pixelBuffer : _pixelBuffers) {
+		if (pixelBuffer.fence) glDeleteSync(pixelBuffer.fence);
+		glDeleteBuffers(1, &pixelBuffer.buffer);
+	}
+
+	clear();
+}
+
+String TextureCache::canonicalPath(const String &path) {
+
+	if (path.empty()) return path;
+
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+	if (error) return path;
+
+	return canonical.make_preferred().string();
+}
+
+GLuint TextureCache::acquire(const String &path, u32 placeholder) {
+
+	String key = canonicalPath(path);
+
+	auto entry = _entries.find(key);
+	if (entry != _entries.end()) {
+		entry->second.refCount++;
+		return entry->second.texture;
+	}
+
+	GLuint texture = createPlaceholder(placeholder);
+
+	// One texel, stored as 4 bytes
+	_entries[key] = { texture, 1, 4, false };
+	_paths[texture] = key;
+	_residentBytes += 4;
+	_pendingCount++;
+
+	_workers.submit([this, key]() {
+		DecodedImage image = { key, nullptr, 0, 0, 0, -1 };
+
+		// Always ask for 3 channels, the texture is stored as RGB whatever the file has
+		i32 channels;
+		image.pixels = stbi_load(key.c_str(), &image.width, &image.height, &channels, 3);
+		if (image.pixels) flipRows(image.pixels, image.width, image.height, 3);
+
+		std::lock_guard<std::mutex> lock(_decodedMutex);
+		_decoded.push_back(image);
+	});
+
+	return texture;
+}
+
+void TextureCache::release(GLuint texture) {
+
+	auto path = _paths.find(texture);
+	if (path == _paths.end()) return;
+
+	auto entry = _entries.find(path->second);
+	if (--entry->second.refCount > 0) return;
+
+	// A decode still in flight finds no entry and is dropped in update()
+	if (!entry->second.loaded) _pendingCount--;
+
+	glDeleteTextures(1, &entry->second.texture);
+	_residentBytes -= entry->second.bytes;
+
+	_entries.erase(entry);
+	_paths.erase(path);
+}
+
+void TextureCache::clear() {
+
+	for (auto &entry : _entries) glDeleteTextures(1, &entry.second.texture);
+
+	_entries.clear();
+	_paths.clear();
+	_residentBytes = 0;
+	_pendingCount = 0;
+}
+
+GLuint TextureCache::createPlaceholder(u32 color) {
+
+	GLuint texture;
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	u8 texel[3] = { (u8)(color >> 16), (u8)(color >> 8), (u8)color };
+
+	// Mutable storage, the decoded image replaces it later without changing the handle
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, texel);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::Instance()->invalidate();
+
+	return texture;
+}
+
+void TextureCache::update() {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock(_decodedMutex);
+		for (DecodedImage &image : _decoded) _uploads.push_back(image);
+		_decoded.clear();
+	}
+
+	while (!_uploads.empty()) {
+		DecodedImage &image = _uploads.front();
+
+		auto entry = _entries.find(image.path);
+
+		// Released while decoding, or a second decode of a path that came back in the meantime
+		if (entry == _entries.end() || entry->second.loaded) {
+			// Only the front image can hold a ring slot, hand it back
+			if (image.pixelBuffer >= 0) _nextPixelBuffer = image.pixelBuffer;
+			stbi_image_free(image.pixels);
+			_uploads.pop_front();
+			continue;
+		}
+
+		if (image.pixels == nullptr) {
+			LOG_DEBUG("Failed to load file %s ", image.path.c_str());
+			entry->second.loaded = true;
+			_pendingCount--;
+			_uploads.pop_front();
+			continue;
+		}
+
+		// Out of budget or no free pixel buffer, carry on next frame
+		if (!stageImage(image, _uploadBudgetMs - elapsedMs(start))) break;
+
+		finishUpload(image, entry->second);
+		stbi_image_free(image.pixels);
+		_uploads.pop_front();
+
+		if (elapsedMs(start) >= _uploadBudgetMs) break;
+	}
+}
+
+// Copies the pixels into the image's pixel buffer, returns true once all of them are there
+bool TextureCache::stageImage(DecodedImage &image, f64 budgetMs) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+	u64 size = (u64)image.width * image.height * 3;
+
+	if (image.pixelBuffer < 0) {
+
+		if (_pixelBuffers.empty()) {
+			_pixelBuffers.resize(kPixelBufferCount, { 0, 0, 0 });
+			for (PixelBuffer &pixelBuffer : _pixelBuffers) glCreateBuffers(1, &pixelBuffer.buffer);
+		}
+
+		PixelBuffer &pixelBuffer = _pixelBuffers[_nextPixelBuffer];
+
+		if (pixelBuffer.fence) {
+			if (glClientWaitSync(pixelBuffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+			glDeleteSync(pixelBuffer.fence);
+			pixelBuffer.fence = 0;
+		}
+
+		if (pixelBuffer.capacity < size) {
+			glNamedBufferData(pixelBuffer.buffer, size, NULL, GL_STREAM_DRAW);
+			pixelBuffer.capacity = size;
+		}
+
+		image.pixelBuffer = _nextPixelBuffer;
+		_nextPixelBuffer = (_nextPixelBuffer + 1) % kPixelBufferCount;
+	}
+
+	PixelBuffer &pixelBuffer = _pixelBuffers[image.pixelBuffer];
+
+	while (image.staged < size) {
+		if (elapsedMs(start) >= budgetMs) return false;
+
+		u64 chunk = std::min(kStageChunkBytes, size - image.staged);
+
+		void *dst = glMapNamedBufferRange(pixelBuffer.buffer, image.staged, chunk,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+		memcpy(dst, image.pixels + image.staged, chunk);
+		glUnmapNamedBuffer(pixelBuffer.buffer);
+
+		image.staged += chunk;
+	}
+
+	return true;
+}
+
+void TextureCache::finishUpload(DecodedImage &image, Entry &entry) {
+
+	PixelBuffer &pixelBuffer = _pixelBuffers[image.pixelBuffer];
+
+	// The driver reads the pixels from the buffer, the call doesn't wait on the copy
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+	glBindTexture(GL_TEXTURE_2D, entry.texture);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	GLStateCache::Instance()->invalidate();
+
+	glGenerateTextureMipmap(entry.texture);
+
+	pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	// Drivers keep RGB8 as 4 bytes per texel, plus a third for the mip chain
+	u64 bytes = (u64)image.width * image.height * 4 * 4 / 3;
+	_residentBytes += bytes - entry.bytes;
+	entry.bytes = bytes;
+
+	entry.loaded = true;
+	_pendingCount--;
+}
@@ -0,0 +1,171 @@
+#include <Core/VertexCacheOptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace NoxEngine;
+
+// Size of the simulated LRU cache, larger than any real one so the order suits every GPU
+static const u32 CacheSize = 32;
+// Weights from the paper
+static const f32 CacheDecayPower = 1.5f;
+static const f32 LastTriangleScore = 0.75f;
+static const f32 ValenceBoostScale = 2.0f;
+static const f32 ValenceBoostPower = 0.5f;
+
+namespace {
+
+	f32 vertexScore(i32 cachePosition, u32 valence) {
+
+		// Nothing left to draw with it
+		if (valence == 0) return -1.0f;
+
+		f32 score = 0.0f;
+		if (cachePosition >= 0) {
+			// The last triangle's vertices score the same, so it isn't favoured to emit it again with a new one
+			if (cachePosition < 3) {
+				score = LastTriangleScore;
+			} else {
+				f32 scale = 1.0f / (CacheSize - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scale, CacheDecayPower);
+			}
+		}
+
+		// Vertices with few triangles left go first, so they don't end up as lone stragglers
+		return score + ValenceBoostScale * std::pow((f32)valence, -ValenceBoostPower);
+	}
+}
+
+void NoxEngine::optimizeVertexCache(Array<i32> &indices, u32 vertexCount) {
+
+	u32 triangleCount = (u32)indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	// Triangles around each vertex, the first valence[v] entries from offsets[v] are the ones not emitted yet
+	Array<u32> valence(vertexCount, 0);
+	for (u32 i = 0; i < triangleCount * 3; i++) valence[indices[i]]++;
+
+	Array<u32> offsets(vertexCount + 1, 0);
+	for (u32 v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + valence[v];
+
+	Array<u32> adjacency(triangleCount * 3);
+	Array<u32> fill(offsets.begin(), offsets.end() - 1);
+	for (u32 i = 0; i < triangleCount * 3; i++) adjacency[fill[indices[i]]++] = i / 3;
+
+	Array<i32> cachePosition(vertexCount, -1);
+	Array<f32> score(vertexCount);
+	for (u32 v = 0; v < vertexCount; v++) score[v] = vertexScore(-1, valence[v]);
+
+	// Starts from the best triangle of the whole mesh, after that only triangles touching the cache are rescored
+	i32 best = 0;
+	f32 bestScore = 0.0f;
+	for (u32 t = 0; t < triangleCount; t++) {
+		f32 s = score[indices[t * 3 + 0]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+		if (s > bestScore) {
+			bestScore = s;
+			best = (i32)t;
+		}
+	}
+
+	Array<u8> emitted(triangleCount, 0);
+	Array<i32> result;
+	result.reserve(triangleCount * 3);
+
+	// The three vertices just used go in front, what falls off the end is out of the cache
+	u32 cache[CacheSize + 3];
+	u32 newCache[CacheSize + 3];
+	u32 cacheCount = 0;
+	u32 nextUnemitted = 0;
+
+	while (result.size() < triangleCount * 3) {
+
+		// Nothing in the cache has triangles left, carry on from the first one not drawn yet
+		if (best < 0) {
+			while (emitted[nextUnemitted]) nextUnemitted++;
+			best = (i32)nextUnemitted;
+		}
+
+		const i32 *triangle = &indices[best * 3];
+		emitted[best] = 1;
+		result.insert(result.end(), triangle, triangle + 3);
+
+		u32 newCount = 0;
+		for (u32 i = 0; i < 3; i++) {
+			u32 v = triangle[i];
+
+			// Swap the triangle out of the vertex's live ones
+			u32 *live = &adjacency[offsets[v]];
+			u32 *found = std::find(live, live + valence[v], (u32)best);
+			std::swap(*found, live[valence[v] - 1]);
+			valence[v]--;
+
+			if (std::find(newCache, newCache + newCount, v) == newCache + newCount) newCache[newCount++] = v;
+		}
+
+		u32 triangleVertices = newCount;
+		for (u32 i = 0; i < cacheCount; i++) {
+			if (std::find(newCache, newCache + triangleVertices, cache[i]) == newCache + triangleVertices) newCache[newCount++] = cache[i];
+		}
+
+		// Rescore the vertices that moved in the cache, including those pushed out
+		for (u32 i = 0; i < newCount; i++) {
+			u32 v = newCache[i];
+			cachePosition[v] = i < CacheSize ? (i32)i : -1;
+			score[v] = vertexScore(cachePosition[v], valence[v]);
+		}
+
+		// Only triangles touching those vertices changed score, the best of them goes next
+		best = -1;
+		bestScore = 0.0f;
+		for (u32 i = 0; i < newCount; i++) {
+			u32 v = newCache[i];
+			for (u32 j = offsets[v]; j < offsets[v] + valence[v]; j++) {
+				u32 t = adjacency[j];
+				f32 s = score[indices[t * 3 + 0]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+				if (s > bestScore) {
+					bestScore = s;
+					best = (i32)t;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, CacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+	}
+
+	indices.swap(result);
+}
+
+void NoxEngine::optimizeVertexFetch(Array<i32> &indices, u32 vertexCount, Array<u32> &remap) {
+
+	remap.assign(vertexCount, ~0u);
+
+	u32 next = 0;
+	for (i32 &index : indices) {
+		if (remap[index] == ~0u) remap[index] = next++;
+		index = (i32)remap[index];
+	}
+
+	for (u32 v = 0; v < vertexCount; v++) {
+		if (remap[v] == ~0u) remap[v] = next++;
+	}
+}
+
+f32 NoxEngine::computeAcmr(const Array<i32> &indices, u32 vertexCount, u32 cacheSize) {
+
+	u32 triangleCount = (u32)indices.size() / 3;
+	if (triangleCount == 0) return 0.0f;
+
+	// A vertex is in the FIFO until cacheSize other vertices went in after it
+	Array<u32> insertedAt(vertexCount, ~0u);
+	u32 misses = 0;
+
+	for (u32 i = 0; i < triangleCount * 3; i++) {
+		u32 v = indices[i];
+		if (insertedAt[v] != ~0u && misses - insertedAt[v] <= cacheSize) continue;
+
+		insertedAt[v] = misses++;
+	}
+
+	return (f32)misses / triangleCount;
+}
@@ -0,0 +1,55 @@
+#include <Core/VertexFormat.h>
+
+#include <glm/gtc/packing.hpp>
+
+using namespace NoxEngine;
+
+static inline f32 signNotZero(f32 v) {
+	return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+u32 NoxEngine::packOctahedral(vec3 dir) {
+
+	f32 l1 = glm::abs(dir.x) + glm::abs(dir.y) + glm::abs(dir.z);
+
+	// Missing normals come in as zero, they decode to +z
+	if (l1 == 0.0f) return glm::packSnorm2x16(vec2(0.0f));
+
+	// Project onto the octahedron, then fold the lower half over the diagonals
+	vec2 oct = vec2(dir.x, dir.y) / l1;
+	if (dir.z < 0.0f) {
+		oct = vec2(
+			(1.0f - glm::abs(oct.y)) * signNotZero(oct.x),
+			(1.0f - glm::abs(oct.x)) * signNotZero(oct.y)
+		);
+	}
+
+	return glm::packSnorm2x16(oct);
+}
+
+vec3 NoxEngine::unpackOctahedral(u32 packed) {
+
+	vec2 oct = glm::unpackSnorm2x16(packed);
+	vec3 dir = vec3(oct.x, oct.y, 1.0f - glm::abs(oct.x) - glm::abs(oct.y));
+
+	if (dir.z < 0.0f) {
+		dir.x = (1.0f - glm::abs(oct.y)) * signNotZero(oct.x);
+		dir.y = (1.0f - glm::abs(oct.x)) * signNotZero(oct.y);
+	}
+
+	return glm::normalize(dir);
+}
+
+u32 NoxEngine::packTexCoord(vec2 uv) {
+	return glm::packHalf2x16(uv);
+}
+
+PackedVertex NoxEngine::packVertex(const vec3 &position, const vec3 &normal, const vec2 &texCoord) {
+
+	PackedVertex vertex;
+	vertex.position = position;
+	vertex.normal = packOctahedral(normal);
+	vertex.texCoord = packTexCoord(texCoord);
+
+	return vertex;
+}
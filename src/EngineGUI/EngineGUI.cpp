@@ -6,6 +6,7 @@
 #include <EngineGUI/ScenePanel.h>
 #include <EngineGUI/PresetObjectPanel.h>
 #include <EngineGUI/ImGuizmoTool.h>
+#include <Utils/FBXFileLoader.h>
 
 using namespace NoxEngine;
 
@@ -65,6 +66,7 @@ void NoxEngineGUI::setupFixedLayout() {
 	ImGui::DockBuilderDockWindow(kPanelNameMap[PanelName::Hierarchy].c_str(), dock_left_down_id);
 	ImGui::DockBuilderDockWindow(kPanelNameMap[PanelName::AnimationSequencerPanel].c_str(), dock_down_id);
 	ImGui::DockBuilderDockWindow(kPanelNameMap[PanelName::SkyboxSettings].c_str(), dock_down_id);
+	ImGui::DockBuilderDockWindow(kPanelNameMap[PanelName::GpuProfilerPanel].c_str(), dock_down_id);
 	ImGui::DockBuilderDockWindow(kPanelNameMap[PanelName::FileExplorer].c_str(), dock_down_down_id);
 
 	// Change node flags here
@@ -120,6 +122,101 @@ void NoxEngineGUI::updateMenu(NoxEngine::GameState& game_state, GUIParams *param
 			ImGui::EndMenu();
 		}
 
+		if (ImGui::BeginMenu("Renderer")) {
+
+			NoxEngine::Renderer *renderer = game_state.renderer;
+
+			bool indirect = renderer->isIndirectDraw();
+			if (ImGui::Checkbox("Multi-draw indirect", &indirect)) renderer->setIndirectDraw(indirect);
+
+			bool culling = renderer->isFrustumCulling();
+			if (ImGui::Checkbox("Frustum culling", &culling)) renderer->setFrustumCulling(culling);
+
+			bool occlusion = renderer->isOcclusionCulling();
+			if (ImGui::Checkbox("Hi-Z occlusion culling", &occlusion)) renderer->setOcclusionCulling(occlusion);
+
+			bool prepass = renderer->isDepthPrepass();
+			if (ImGui::Checkbox("Depth pre-pass", &prepass)) renderer->setDepthPrepass(prepass);
+
+			bool frontToBack = renderer->isFrontToBack();
+			if (ImGui::Checkbox("Sort front to back before state", &frontToBack)) renderer->setFrontToBack(frontToBack);
+
+			bool overdraw = renderer->isOverdrawView();
+			if (ImGui::Checkbox("Show overdraw", &overdraw)) renderer->setOverdrawView(overdraw);
+
+			bool grid = renderer->isGridVisible();
+			if (ImGui::Checkbox("Grid", &grid)) renderer->setGridVisible(grid);
+
+			float gridSpacing = renderer->getGridSpacing();
+			if (ImGui::SliderFloat("Grid spacing", &gridSpacing, 1.0f, 100.0f)) renderer->setGridSpacing(gridSpacing);
+
+			float gridFade = renderer->getGridFadeDistance();
+			if (ImGui::SliderFloat("Grid fade distance", &gridFade, 100.0f, 5000.0f)) renderer->setGridFadeDistance(gridFade);
+
+			float lodPixelError = renderer->getLodPixelError();
+			if (ImGui::SliderFloat("LOD pixel error", &lodPixelError, 0.0f, 8.0f)) renderer->setLodPixelError(lodPixelError);
+
+			const NoxEngine::RenderStats &stats = renderer->getRenderStats();
+			ImGui::Text("Objects drawn: %u, culled: %u, occluded: %u", stats.objectsDrawn, stats.objectsCulled, stats.objectsOccluded);
+			ImGui::Text("Draw calls: %u, %u of them depth pre-pass", stats.drawCalls, stats.prepassDrawCalls);
+			ImGui::Text("Triangles: %u, %u at full detail", stats.trianglesDrawn, stats.trianglesFullDetail);
+			ImGui::Text("Shaded fragments per pixel: %.2f", stats.shadedPerPixel);
+			ImGui::Text("Shared geometries: %u", stats.sharedGeometries);
+			ImGui::Text("Submit: %.3f ms", stats.submitMs);
+
+			const NoxEngine::GLStateStats &binds = NoxEngine::GLStateCache::Instance()->getStats();
+			ImGui::Text("GL binds: issued %u, skipped %u", binds.bindsIssued, binds.bindsSkipped);
+
+			const NoxEngine::StreamBufferStats &stream = NoxEngine::StreamBuffer::Instance()->getStats();
+			ImGui::Text("Stream buffer: %.1f of %.1f KB per frame, peak %.1f KB, waited %.3f ms", stream.lastFrameBytes / 1024.0,
+					stream.frameCapacity / 1024.0, stream.peakFrameBytes / 1024.0, stream.waitMs);
+
+			NoxEngine::FramePipeline *pipeline = game_state.framePipeline;
+			bool pipelined = pipeline->isPipelined();
+			if (ImGui::Checkbox("Simulate next frame while drawing", &pipelined)) pipeline->setPipelined(pipelined);
+
+			const NoxEngine::FramePacingStats &pacing = pipeline->getStats();
+			ImGui::Text("Simulation: %.3f ms, render: %.3f ms", pacing.simulationMs, pacing.renderMs);
+			ImGui::Text("Overlap: %.3f ms, waited: %.3f ms", pacing.overlapMs, pacing.waitMs);
+
+			ImGui::Text("Lights: %u, binning: %.3f ms, %u cluster entries", renderer->getNumLights(), stats.lightBinningMs, stats.clusterLightIndices);
+			if (ImGui::MenuItem("Spawn 1000 point lights")) {
+				game_state.activeScene->addPointLights(1000, vec3(-500.0f, 1.0f, -500.0f), vec3(500.0f, 50.0f, 500.0f), 40.0f);
+			}
+
+			if (ImGui::MenuItem("Log vertex cache ACMR of assets/meshes")) NoxEngine::reportVertexCache("assets/meshes");
+
+			NoxEngine::DynamicResolution &resolution = renderer->getDynamicResolution();
+			bool dynamicResolution = resolution.isEnabled();
+			if (ImGui::Checkbox("Dynamic resolution", &dynamicResolution)) resolution.setEnabled(dynamicResolution);
+
+			NoxEngine::DynamicResolutionSettings resolutionSettings = resolution.getSettings();
+			float targetMs = (float)resolutionSettings.targetMs;
+			bool settingsChanged = ImGui::SliderFloat("Min scale", &resolutionSettings.minScale, 0.25f, 1.0f);
+			settingsChanged |= ImGui::SliderFloat("Max scale", &resolutionSettings.maxScale, 0.25f, 1.0f);
+			if (ImGui::SliderFloat("Target GPU ms", &targetMs, 4.0f, 33.0f)) {
+				resolutionSettings.targetMs = targetMs;
+				settingsChanged = true;
+			}
+			if (settingsChanged) {
+				resolutionSettings.maxScale = std::max(resolutionSettings.maxScale, resolutionSettings.minScale);
+				resolution.setSettings(resolutionSettings);
+			}
+
+			float sharpness = renderer->getUpscaleSharpness();
+			if (ImGui::SliderFloat("Upscale sharpness", &sharpness, 0.0f, 1.0f)) renderer->setUpscaleSharpness(sharpness);
+
+			ImGui::Text("Render scale: %.2f, %ux%u, average %.3f ms", renderer->getRenderScale(), renderer->getRenderWidth(), renderer->getRenderHeight(), resolution.getAverageMs());
+
+			const NoxEngine::TextureCache &textures = renderer->getTextureCache();
+			ImGui::Text("Textures: %u, %.2f MB, %u loading", textures.getTextureCount(), textures.getResidentBytes() / (1024.0 * 1024.0), textures.getPendingCount());
+
+			float uploadBudget = (float)textures.getUploadBudget();
+			if (ImGui::SliderFloat("Texture upload ms", &uploadBudget, 0.25f, 16.0f)) renderer->setTextureUploadBudget(uploadBudget);
+
+			ImGui::EndMenu();
+		}
+
 		if (ImGui::BeginMenu("Preferences")) {
 
 
@@ -48,6 +48,9 @@ f32 padding_right = 5.0f;
 f32 ratio = 16.0f/9.0f;
 char temp_buf[256];
 
+const char* resolution_names[] = { "Full", "Half", "Quarter" };
+const f32 resolution_scales[] = { 1.0f, 0.5f, 0.25f };
+
 void TextureView(const char *tree_name, const char *file_path, FullscreenShader& pp, Array<FullscreenShader>& pps, u32 main_renderer_tex_id, GameState *state) {
 
 	if(ImGui::TreeNodeEx(pp.GetName(), ImGuiTreeNodeFlags_Framed | ImGuiTreeNodeFlags_DefaultOpen, "%s", pp.GetName())) {
@@ -55,8 +58,18 @@ void TextureView(const char *tree_name, const char *file_path, FullscreenShader&
 		ImGui::Unindent();
 		ImGui::Indent(padding_right);
 
+		i32 pass_index = (i32)(&pp - &pps[0]);
+
 		ImGui::Text("Texture ID: %d", pp.GetTexture());
 
+		i32 resolution = 0;
+		while(resolution < 2 && resolution_scales[resolution] > pp.GetResolutionScale()) resolution++;
+
+		ImGui::SetNextItemWidth(120.0f);
+		if(ImGui::Combo("Resolution", &resolution, resolution_names, 3)) {
+			pp.SetResolutionScale(resolution_scales[resolution]);
+		}
+
 		bool openInputs = ImGui::TreeNode("Inputs");
 
 		ImGui::SameLine();
@@ -87,9 +100,8 @@ void TextureView(const char *tree_name, const char *file_path, FullscreenShader&
 					selected_texture = 0;
 				}
 
-				for(u32 i = 0; i < pps.size(); i++) {
-
-					if(&pp == &pps[i]) continue;
+				// Only earlier passes have an output by the time this one runs
+				for(i32 i = 0; i < pass_index; i++) {
 
 					ImGui::PushID(i);
 					snprintf(temp_buf, 256, "Tex: %s, TexID: %d", pps[i].GetName(), pps[i].GetTexture());
@@ -126,10 +138,9 @@ void TextureView(const char *tree_name, const char *file_path, FullscreenShader&
 			if(ImGui::Button("Add Input")) {
 
 				if(selected_texture == 0) {
-					pp.AddInput(main_renderer_tex_id, selected_texture_unit);
-				} else {
-					selected_texture -= 1;
-					pp.AddInput(pps[selected_texture].GetTexture(), selected_texture_unit);
+					pp.AddInput(kMainRendererInput, selected_texture_unit);
+				} else if(selected_texture - 1 < pass_index) {
+					pp.AddInput(selected_texture - 1, selected_texture_unit);
 				}
 
 				selected_texture = 0;
@@ -153,7 +164,8 @@ void TextureView(const char *tree_name, const char *file_path, FullscreenShader&
 			i32 item_to_delete = -1;
 			for(u32 i = 0; i < inputs.size(); i++) {
 				ImGui::SetNextItemWidth(ImGui::GetWindowContentRegionWidth() - 100.0f);
-				snprintf(temp_buf, 256, "TexID: %d, Tex Unit: %d", inputs[i].texture_id, inputs[i].texture_location);
+				const char *source_name = inputs[i].source == kMainRendererInput ? "Main Renderer" : pps[inputs[i].source].GetName();
+				snprintf(temp_buf, 256, "Source: %s, Tex Unit: %d", source_name, inputs[i].texture_location);
 				ImGui::InputText("", temp_buf, 256, ImGuiInputTextFlags_ReadOnly);
 
 				if(ImGui::GetActiveID() == ImGui::GetID("")) {
@@ -196,11 +208,13 @@ void TextureView(const char *tree_name, const char *file_path, FullscreenShader&
 		ImVec2 wsize;
 		wsize.x = ImGui::GetContentRegionAvail().x;
 		wsize.y = wsize.x/ratio;
-		if(pp.IsInit())
+		if(pp.GetTexture() != 0)
 			ImGui::Image((ImTextureID)(u64)pp.GetTexture(), wsize, ImVec2(0, 1), ImVec2(1, 0));
+		else if(pp.IsInit())
+			ImGui::Text("Not run, nothing reads or shows its output");
 
 		if(ImGui::Button("Preview")) {
-			state->fullscreen_shader_texture_used = pp.GetTexture();
+			state->fullscreen_shader_pass_used = pass_index;
 		}
 
 		ImGui::TreePop();
@@ -218,9 +232,18 @@ void NoxEngineGUI::updatePostProcessorsPanel(GameState* state, GUIParams *ui_par
 	ImGui::Begin(name.c_str(), NULL, flags);
 
 	if(ImGui::Button("Add Post Processor")) {
-		state->post_processors.emplace_back(state->win_width, state->win_height);
+		state->post_processors.emplace_back();
 	}
 
+	PostProcessChain &chain = state->post_process_chain;
+	const PostProcessStats &stats = chain.getStats();
+
+	bool keep_outputs = chain.isKeepOutputs();
+	if(ImGui::Checkbox("Keep every pass output", &keep_outputs)) chain.setKeepOutputs(keep_outputs);
+
+	ImGui::Text("Passes run: %u, skipped: %u, targets: %u", stats.passesRun, stats.passesSkipped, stats.targets);
+	ImGui::Text("Targets: %.2f MB, one per pass: %.2f MB", stats.pooledBytes / (1024.0 * 1024.0), stats.perPassBytes / (1024.0 * 1024.0));
+
 	if(ImGui::TreeNodeEx("Main Renderer", ImGuiTreeNodeFlags_Framed | ImGuiTreeNodeFlags_DefaultOpen)) {
 		
 		ImGui::Unindent();
@@ -237,6 +260,10 @@ void NoxEngineGUI::updatePostProcessorsPanel(GameState* state, GUIParams *ui_par
 		wsize.x = ImGui::GetContentRegionAvail().x - padding_right;
 		wsize.y = (9.0f/16.0f)*wsize.x;
 		ImGui::Image((ImTextureID)(u64)state->renderer->getTexture(), wsize, ImVec2(0, 1), ImVec2(1, 0));
+
+		if(ImGui::Button("Preview")) {
+			state->fullscreen_shader_pass_used = -1;
+		}
 		ImGui::PopID();
 		ImGui::TreePop();
 
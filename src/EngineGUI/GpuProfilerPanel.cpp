@@ -0,0 +1,47 @@
+#include <EngineGUI/GpuProfilerPanel.h>
+#include <Core/GpuProfiler.h>
+
+using namespace NoxEngine;
+
+
+void NoxEngineGUI::updateGpuProfilerPanel(NoxEngine::GameState* state) {
+
+	String name = kPanelNameMap[PanelName::GpuProfilerPanel];
+	GpuProfiler *profiler = GpuProfiler::Instance();
+
+	// Window Begin
+	ImGui::Begin(name.c_str());
+
+	bool enabled = profiler->isEnabled();
+	if (ImGui::Checkbox("Enabled", &enabled)) profiler->setEnabled(enabled);
+
+	ImGui::SameLine();
+	if (ImGui::Button("Export CSV")) profiler->writeCsv("gpu_timings.csv");
+
+	ImGui::SameLine();
+	ImGui::Text("Averaged over %u frames, %u frames dropped", GpuTimer::HistorySize, profiler->getDroppedFrames());
+
+	ImGui::Separator();
+
+	ImGui::Columns(5, "GpuTimers");
+	ImGui::Text("Scope"); ImGui::NextColumn();
+	ImGui::Text("Average ms"); ImGui::NextColumn();
+	ImGui::Text("Last ms"); ImGui::NextColumn();
+	ImGui::Text("Min ms"); ImGui::NextColumn();
+	ImGui::Text("Max ms"); ImGui::NextColumn();
+	ImGui::Separator();
+
+	// Timers are listed in the order they were first seen, which keeps children right after their parent
+	for (const GpuTimer &timer : profiler->getTimers()) {
+		ImGui::Text("%*s%s", (i32)timer.depth * 2, "", timer.name.c_str()); ImGui::NextColumn();
+		ImGui::Text("%.3f", timer.averageMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", timer.lastMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", timer.minMs); ImGui::NextColumn();
+		ImGui::Text("%.3f", timer.maxMs); ImGui::NextColumn();
+	}
+
+	ImGui::Columns(1);
+
+	// Window End
+	ImGui::End();
+}
@@ -204,13 +204,16 @@ void NoxEngineGUI::updateInspectorPanel(NoxEngine::GameState* state, GUIParams *
 
 						ImGui::Text("Position");
 						ImGui::SameLine();
-						ImGui::DragFloat3("##Position", &transComp->x, 0.1f);
+						bool changed = ImGui::DragFloat3("##Position", &transComp->x, 0.1f);
 						ImGui::Text("Rotation");
 						ImGui::SameLine();
-						ImGui::DragFloat3("##Rotation", &transComp->rx, 0.01f);
+						changed |= ImGui::DragFloat3("##Rotation", &transComp->rx, 0.01f);
 						ImGui::Text("   Scale");
 						ImGui::SameLine();
-						ImGui::DragFloat3("##Scale", &transComp->sx, 0.01f);
+						changed |= ImGui::DragFloat3("##Scale", &transComp->sx, 0.01f);
+
+						// The fields are edited in place, bypassing the setters
+						if (changed) transComp->markDirty();
 
 						ImGui::TreePop();
 
@@ -122,13 +122,16 @@ void NoxEngineGUI::initPresetObject()
 		{NoxEngine::TransformType,		new NoxEngine::TransformComponent(0, 0, 0)}
 	};
 	// Cube Preset
+	NoxEngine::RenderableComponent *cube = new NoxEngine::RenderableComponent(0.0f, 0.0f, 0.0f, "");
+	cube->geometryKey = "preset#cube";
 	PRESET_OBJECT_COMPONENTS[PresetObject::Cube] = {
 		{NoxEngine::TransformType,		new NoxEngine::TransformComponent(0, 0, 0)},
-		{NoxEngine::RenderableType,		new NoxEngine::RenderableComponent(0.0f, 0.0f, 0.0f, "")}
+		{NoxEngine::RenderableType,		cube}
 	};
 	// Sphere Preset
 	String file_name = "assets/meshes/sphere.fbx";
 	NoxEngine::MeshScene sphereScene = NoxEngine::readFBX(file_name.c_str());
+	sphereScene.setGeometryKeys(file_name);
 	PRESET_OBJECT_COMPONENTS[PresetObject::Sphere] = {
 		{NoxEngine::TransformType,		new NoxEngine::TransformComponent(0, 0, 0)},
 		{NoxEngine::RenderableType,		new NoxEngine::Mesh(*sphereScene.meshes[0])}
@@ -136,6 +139,7 @@ void NoxEngineGUI::initPresetObject()
 	// Card Preset
 	file_name = "assets/meshes/card.fbx";
 	NoxEngine::MeshScene cardScene = NoxEngine::readFBX(file_name.c_str());
+	cardScene.setGeometryKeys(file_name);
 	PRESET_OBJECT_COMPONENTS[PresetObject::RectangleCard] = {
 		{NoxEngine::TransformType,		new NoxEngine::TransformComponent(0, 0, 0)},
 		{NoxEngine::RenderableType,		new NoxEngine::Mesh(*cardScene.meshes[0])}
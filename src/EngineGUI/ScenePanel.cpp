@@ -183,11 +183,7 @@ void NoxEngineGUI::updateScenePanel(GameState* state, GUIParams *params) {
 				}
 				else
 				{
-					ITransform* pos = ent->getComp<TransformComponent>()->CastType<ITransform>();
-					translation = glm::translate(mat4(1.0f), vec3(pos->x, pos->y, pos->z));
-					rotation = glm::eulerAngleXYZ(pos->rx, pos->ry, pos->rz);
-					scale = glm::scale(mat4(1.0f), vec3(pos->sx, pos->sy, pos->sz));
-					worldMat = translation * rotation * scale;
+					worldMat = ent->getComp<TransformComponent>()->getWorldMatrix();
 				}
 			}
 
@@ -237,7 +233,7 @@ void NoxEngineGUI::updateScenePanel(GameState* state, GUIParams *params) {
 					}
 					else
 					{
-						ITransform* pos = ent->getComp<TransformComponent>()->CastType<ITransform>();
+						TransformComponent* pos = ent->getComp<TransformComponent>();
 						pos->x = translation_temp[0];
 						pos->y = translation_temp[1];
 						pos->z = translation_temp[2];
@@ -247,6 +243,7 @@ void NoxEngineGUI::updateScenePanel(GameState* state, GUIParams *params) {
 						pos->sx = scale_temp[0];
 						pos->sy = scale_temp[1];
 						pos->sz = scale_temp[2];
+						pos->markDirty();
 					}
 				}
 			}
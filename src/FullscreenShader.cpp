@@ -2,48 +2,25 @@
 #include <Utils/Utils.h>
 #include <Utils/MemAllocator.h>
 #include <Managers/LiveReloadManager.h>
+#include <Core/GLStateCache.h>
 
 using namespace NoxEngine;
 
 
 
-FullscreenShader::FullscreenShader(u32 frame_width, u32 frame_height, const char *name)
+FullscreenShader::FullscreenShader(const char *name)
 	:GLProgram(Array<ShaderFile>{
 		{"assets/shaders/fullScreenShader.vert", GL_VERTEX_SHADER, 0},
 	}),
 	texture_inputs(),
-	frame_width(frame_width),
-	frame_height(frame_height),
-	current_bound_program(0),
-	current_bound_texture(0),
-	current_bound_framebuffer(0),
+	frame_width(0),
+	frame_height(0),
+	resolution_scale(1.0f),
 	name(name),
 	inited(false),
 	framebuffer_id(0),
 	texture_id(0)
 {
-
-	saveState();
-
-	glGenFramebuffers(1, &framebuffer_id);
-	glGenTextures(1, &texture_id);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
-	glBindTexture(GL_TEXTURE_2D, texture_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_width, frame_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_id, 0);
-
-	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
-		LOG_DEBUG("Fullscreen post-processor successfully built");
-	} else {
-		LOG_DEBUG("Failed to build fullscreen post-processor");
-	}
-
-	restoreState();
 }
 
 FullscreenShader::~FullscreenShader() {
@@ -66,50 +43,12 @@ FullscreenShader::FullscreenShader(const FullscreenShader& other)
 	texture_inputs(other.texture_inputs),
 	frame_width(other.frame_width),
 	frame_height(other.frame_height),
-	current_bound_program(0),
-	current_bound_texture(0),
-	current_bound_framebuffer(0),
+	resolution_scale(other.resolution_scale),
 	name(other.name),
-	framebuffer_id(0),
-	texture_id(0),
+	framebuffer_id(other.framebuffer_id),
+	texture_id(other.texture_id),
 	inited(false)
 {
-
-	saveState();
-
-	if(other.framebuffer_id == 0) {
-		glGenFramebuffers(1, &framebuffer_id);
-		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
-	} else {
-		framebuffer_id = other.framebuffer_id;
-	}
-
-
-	if(other.texture_id == 0) {
-
-		glGenTextures(1, &texture_id);
-		glBindTexture(GL_TEXTURE_2D, texture_id);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_width, frame_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	} else {
-		texture_id = other.texture_id;
-	}
-
-	if(other.texture_id == 0)
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_id, 0);
-
-	if(other.framebuffer_id == 0) {
-		if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
-			LOG_DEBUG("Fullscreen post-processor successfully built");
-		} else {
-			LOG_DEBUG("Failed to build fullscreen post-processor");
-		}
-	}
-
-	restoreState();
-
 	if(!fragment_shader.empty()) {
 		ChangeShader(fragment_shader);
 		LiveReloadManager::Instance()->addLiveReloadEntry(fragment_shader.c_str(), static_cast<IReloadableFile*>(this));
@@ -118,51 +57,28 @@ FullscreenShader::FullscreenShader(const FullscreenShader& other)
 }
 
 
-FullscreenShader::FullscreenShader(const String shader_src, Array<TextureInput> texture_inputs, u32 frame_width, u32 frame_height, const char *name)
+FullscreenShader::FullscreenShader(const String shader_src, Array<TextureInput> texture_inputs, const char *name)
 	:GLProgram(Array<ShaderFile>{
 		{"assets/shaders/fullScreenShader.vert", GL_VERTEX_SHADER, 0},
 		{shader_src, GL_FRAGMENT_SHADER, 0}
 	}),
 	fragment_shader(shader_src),
 	texture_inputs(texture_inputs),
-	frame_width(frame_width),
-	frame_height(frame_height),
-	current_bound_program(0),
-	current_bound_texture(0),
-	current_bound_framebuffer(0),
-	name(name)
+	frame_width(0),
+	frame_height(0),
+	resolution_scale(1.0f),
+	name(name),
+	framebuffer_id(0),
+	texture_id(0)
 {
-
-	saveState();
-
-	glGenFramebuffers(1, &framebuffer_id);
-	glGenTextures(1, &texture_id);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
-	glBindTexture(GL_TEXTURE_2D, texture_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_width, frame_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_id, 0);
-
-	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
-		LOG_DEBUG("Fullscreen post-processor successfully built : %s", shader_src.c_str());
-	} else {
-		LOG_DEBUG("Failed to build fullscreen post-processor : %s", shader_src.c_str());
-	}
-
-	restoreState();
 	inited = true;
 
-	IReloadableFile *x = static_cast<IReloadableFile*>(this);
 	LiveReloadManager::Instance()->addLiveReloadEntry(fragment_shader.c_str(), static_cast<IReloadableFile*>(this));
 }
 
 
-void FullscreenShader::AddInput(u32 texture_id, u32 texture_location) {
-	texture_inputs.push_back({texture_id, texture_location});
+void FullscreenShader::AddInput(i32 source, u32 texture_location) {
+	texture_inputs.push_back({source, texture_location});
 }
 
 void FullscreenShader::RemoveInput(i32 input_index) {
@@ -174,24 +90,38 @@ bool FullscreenShader::ChangeShader(String& shader_path) {
 
 	if(shader == 0) return false;
 
+	// The relink below replaces whatever the constructor linked, its result isn't wanted any more
+	finishLink();
+
 	u32 shaders_attached[2];
+	i32 attached_count = 0;
+	bool has_vertex_shader = false;
+
+	glGetAttachedShaders(_id, 2, &attached_count, shaders_attached);
+
+	i32 shader_type = 0;
+	for(i32 i = 0; i < attached_count; i++) {
+		glGetShaderiv(shaders_attached[i], GL_SHADER_TYPE, &shader_type);
+		if(shader_type == GL_FRAGMENT_SHADER) {
+			glDetachShader(_id, shaders_attached[i]);
+			glDeleteShader(shaders_attached[i]);
+		} else if(shader_type == GL_VERTEX_SHADER) {
+			has_vertex_shader = true;
+		}
+	}
 
-	if(inited) {
-		glGetAttachedShaders(_id, 2, NULL, shaders_attached);
-
-		i32 shader_type = 0;
-		for(u32 i = 0; i < 2; i++) {
-			glGetShaderiv(shaders_attached[i], GL_SHADER_TYPE, &shader_type);
-			if(shader_type == GL_FRAGMENT_SHADER) {
-				glDetachShader(_id, shaders_attached[i]);
-				glDeleteShader(shaders_attached[i]);
-				break;
-			}
+	// Restored from the binary cache, the program has no shaders attached to relink with
+	if(!has_vertex_shader) {
+		for(u32 i = 0; i < _shaders.size(); i++) {
+			if(_shaders[i].shader_type != GL_VERTEX_SHADER) continue;
+			u32 vertex_shader = compileShader(_shaders[i].filename, GL_VERTEX_SHADER);
+			if(vertex_shader != 0) glAttachShader(_id, vertex_shader);
 		}
 	}
 
 	glAttachShader(_id, shader);
 	glLinkProgram(_id);
+	invalidateUniformLocations();
 
 	// Check the program
 	i32 result;
@@ -226,66 +156,33 @@ void FullscreenShader::liveReloadFile(const char* filename, LiveReloadEntry *ent
 }
 
 
-void FullscreenShader::saveState() {
-	// glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &current_bound_texture);
-	// glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &current_bound_framebuffer);
-	glGetIntegerv(GL_CURRENT_PROGRAM, &current_bound_program);
-}
+void FullscreenShader::draw(time_type deltaTime, const Array<u32> &input_textures) {
 
-void FullscreenShader::restoreState() {
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glUseProgram(current_bound_program);
 
-}
+	if(!inited || framebuffer_id == 0) return;
 
-void FullscreenShader::draw(time_type deltaTime) {
-
-
-	if(!inited) return;
-
-	saveState();
+	GLStateCache *state = GLStateCache::Instance();
 	use();
 
 	setFloat("dt", deltaTime);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
+	state->bindFramebuffer(framebuffer_id);
+	glViewport(0, 0, frame_width, frame_height);
 
 	for(u32 i = 0; i < texture_inputs.size(); i++) {
-		glActiveTexture(GL_TEXTURE0 + texture_inputs[i].texture_location);
-		glBindTexture(GL_TEXTURE_2D, texture_inputs[i].texture_id);
+		state->bindTexture(texture_inputs[i].texture_location, input_textures[i]);
 	}
 
 	// the vertex shader is common across all fullscreen shaders
 	// it just contains the coords for a quad and here it renders that quad
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
-	restoreState();
+	state->bindFramebuffer(0);
 }
 
 
-void FullscreenShader::changeTextureSize(i32 width, i32 height) {
-
+void FullscreenShader::setOutput(u32 framebuffer, u32 texture, u32 width, u32 height) {
+	framebuffer_id = framebuffer;
+	texture_id = texture;
 	frame_width = width;
 	frame_height = height;
-
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
-	glBindTexture(GL_TEXTURE_2D, texture_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frame_width, frame_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_id, 0);
-
-	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE) {
-		LOG_DEBUG("Fullscreen post-processor successfully built.");
-	} else {
-		LOG_DEBUG("Failed to build fullscreen post-processor.");
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	glViewport(0, 0, width, height);
-
-
 }
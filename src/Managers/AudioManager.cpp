@@ -416,14 +416,12 @@ int AudioManager::createGeometry(Entity* ent) {
 	vec3 scale( 1.0f );
 
 	// Get transform if the entity has one
-	ITransform* itrans = ent->getComp<TransformComponent>();
+	TransformComponent* itrans = ent->getComp<TransformComponent>();
 	if (itrans && ent->isEnabled<TransformComponent>()) {
 
-		mat4 rotation = glm::eulerAngleXYZ(itrans->rx, itrans->ry, itrans->rz);
-
 		pos		= vec3(itrans->x, itrans->y, itrans->z);
-		forward = rotation * vec4(forward, 1.0f);
-		up		= rotation * vec4(up, 1.0f);
+		forward = itrans->getForward();
+		up		= itrans->getUp();
 		scale	= vec3(itrans->sx, itrans->sy, itrans->sz);
 	}
 
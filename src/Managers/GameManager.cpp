@@ -25,8 +25,12 @@
 #include <EngineGUI/ImGuizmoTool.h>
 #include <EngineGUI/SkyboxPanel.h>
 #include <EngineGUI/FullscreenShaderPanel.h>
+#include <EngineGUI/GpuProfilerPanel.h>
 
 #include <FullscreenShader.h>
+#include <Core/GLStateCache.h>
+#include <Core/GpuProfiler.h>
+#include <Managers/SaveLoadManager.h>
 
 using NoxEngineUtils::Logger;
 using NoxEngine::EventManager;
@@ -40,10 +44,19 @@ GameManager::GameManager() :
 	ui_params(),
 	should_close(false),
 	keys(),
-	game_state()
+	game_state(),
+	framePipeline(),
+	benchmark(nullptr)
 {
 	game_state.win_width = WINDOW_WIDTH;
 	game_state.win_height = WINDOW_HEIGHT;
+	game_state.framePipeline = &framePipeline;
+}
+
+void GameManager::setHeadless(const BenchmarkSettings &settings) {
+	benchmark = new HeadlessBenchmark(settings);
+	game_state.win_width = settings.width;
+	game_state.win_height = settings.height;
 }
 
 void GameManager::init() {
@@ -60,18 +73,56 @@ void GameManager::init() {
 	init_renderer();
 	//init_scripts();
 	init_postprocess();
+
+	if (benchmark && !benchmark->getSettings().scenePath.empty()) {
+		loadScene(benchmark->getSettings().scenePath, game_state);
+	}
+
+	if (benchmark) {
+		renderer->setDepthPrepass(benchmark->getSettings().depthPrepass);
+		renderer->setOcclusionCulling(benchmark->getSettings().occlusionCulling);
+		renderer->setOverdrawView(benchmark->getSettings().showOverdraw);
+		renderer->setLodPixelError(benchmark->getSettings().lodPixelError);
+	}
 }
 
 void GameManager::update() {
 
+	if (benchmark) benchmark->beginFrame(renderer->getCamera());
+
+	// The entities are ours again until the next launch
+	framePipeline.waitForSimulation();
+
+	// The GUI of the last frame bound behind the cache's back
+	GLStateCache::Instance()->beginFrame();
+	GpuProfiler::Instance()->beginFrame();
+	StreamBuffer::Instance()->nextFrame();
+
+	update_time();
+	update_render_scale();
 	update_livereloads();
 	update_inputs();
+
+	// Panels edit entities, so they are built while the simulation is idle and only drawn after the scene
+	if (!benchmark) update_gui();
+
 	update_ecs();
-	update_animation();
-	update_audio();
-	update_renderer();
+
+	// Draw from the packet simulated during the last frame while the next one is simulated
+	const RenderPacket &packet = framePipeline.launchSimulation([this](RenderPacket &next) { simulate(next); });
+
+	update_renderer(packet);
 	update_postprocessors();
-	update_gui();
+
+	if (benchmark) {
+		benchmark->endFrame(renderer, framePipeline.getStats());
+		if (benchmark->isDone()) {
+			benchmark->writeCsv();
+			should_close = true;
+		}
+	} else {
+		draw_gui();
+	}
 
 	// Support closing via close button again
 	if (glfwWindowShouldClose(window)) {
@@ -79,6 +130,18 @@ void GameManager::update() {
 	}
 
 	glfwSwapBuffers(window);
+	framePipeline.endFrame();
+
+	// Nothing may be left running on the entities once the loop exits
+	if (should_close) framePipeline.waitForSimulation();
+}
+
+// Runs on FramePipeline's thread, everything it touches is left alone by the main thread until waitForSimulation()
+void GameManager::simulate(RenderPacket &packet) {
+	update_animation();
+	update_transforms();
+	update_audio();
+	renderer->recordRenderPacket(packet);
 }
 
 // Whenever an entity is created, modified, or deleted, call this function
@@ -108,10 +171,6 @@ void GameManager::createAudioGeometry(Entity* ent, IAudioGeometry* igeo) {
 			igeo->meshScene->meshes[i]->rendObjId = igeo->rendObjId;
 		}
 	}
-
-	// Update renderer
-	// TODO-OPTIMIZATION: Set a flag inside GameManager, update buffers in a batch fashion
-	this->renderer->updateBuffers();
 }
 
 
@@ -140,6 +199,9 @@ void GameManager::init_window() {
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
 	glfwWindowHint(GLFW_SAMPLES, 4);
 
+	// Benchmarks render into the Renderer's framebuffer only, the window just carries the context
+	if (benchmark) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
 	window = glfwCreateWindow(game_state.win_width, game_state.win_height, title.c_str(), nullptr, nullptr);
 
 	glfwMakeContextCurrent(window);
@@ -213,7 +275,8 @@ void GameManager::init_events() {
 
 			// Add to hash map if it does not exist
 			if (game_state.meshScenes.find(file_name) == game_state.meshScenes.end()) {
-				game_state.meshScenes.emplace(file_name, NoxEngine::readFBX(file_name.c_str()));
+				auto inserted = game_state.meshScenes.emplace(file_name, NoxEngine::readFBX(file_name.c_str()));
+				inserted.first->second.setGeometryKeys(file_name);
 			}
 			MeshScene& meshScene = game_state.meshScenes.find(file_name)->second;
 
@@ -226,7 +289,8 @@ void GameManager::init_events() {
 				Entity* ent = new Entity(game_state.activeScene, meshScene.meshes[i]->name.c_str(),
 					file_name.c_str());
 
-				Mesh* mesh = new Mesh(*meshScene.meshes[i]);
+				// Shares the scene's arrays, the renderer uploads the geometry once per mesh key
+				Mesh* mesh = new Mesh(meshScene.meshes[i]);
 				RenderableComponent* comp = mesh;
 				TransformComponent* trans = new TransformComponent(0.0, 0.0, 0.0);
 
@@ -252,6 +316,8 @@ void GameManager::init_events() {
 
 				game_state.activeScene->addEntity(ent);
 			}
+
+			renderer->logGeometryStats();
 	});
 
 
@@ -268,8 +334,6 @@ void GameManager::init_events() {
 				if (!renderer->hasRendObj(rendComp->rendObjId)) {
 
 					renderer->addObject(ent, rendComp, ComponentType::RenderableType);
-
-					this->renderer->updateBuffers();
 				}
 			}
 
@@ -299,8 +363,6 @@ void GameManager::init_events() {
 				if (!renderer->hasRendObj(lisComp->rendObjId)) {
 					
 					renderer->addObject(ent, lisComp, ComponentType::AudioListenerType);
-
-					this->renderer->updateBuffers();
 				}
 			}
 
@@ -314,8 +376,13 @@ void GameManager::init_events() {
 			const std::type_index compTypeId = va_arg(args, std::type_index);
 
 			if (compTypeId == typeid(RenderableComponent)) {
+				// Frees the object's ranges in the geometry pools
 				renderer->removeObject(ent->getComp<RenderableComponent>()->rendObjId);
-				// TODO-OPTIMIZATION: Remove in batches every X ms, shift the still-valid indices to take the free space
+			}
+
+			// Light/Emission
+			if (compTypeId == typeid(EmissionComponent)) {
+				renderer->removeLight(ent);
 			}
 
 			// Audio
@@ -376,6 +443,9 @@ void GameManager::init_shaders() {
 		{ "assets/shaders/fragmentShader.fs", GL_FRAGMENT_SHADER, 0 }
 	});
 
+	// Both were only started above, with parallel compile the driver builds them at the same time
+	for (GLProgram &program : programs) program.finishLink();
+
 	current_program = &programs[0];
 }
 
@@ -394,10 +464,7 @@ void GameManager::init_renderer() {
 	game_state.renderer = renderer;
 	renderer->setFrameBufferToTexture();
 	game_state.fullscreen_shader_texture_used = renderer->getTexture();
-
-	GridObject *obj = new GridObject(vec3(-1500, 0, -1500), vec3(1500, 0, 1500), 150);
-	renderer->addPermObject(obj);
-	renderer->updateBuffers();
+	game_state.fullscreen_shader_pass_used = -1;
 
 	// MULTIPLE LIGHTS Init lights. Will be removed when light will be added dinamically
 	//for (u32 i = 0; i < 3; i++)
@@ -412,14 +479,16 @@ void GameManager::init_renderer() {
 
 void GameManager::init_gui() {
 
-	NoxEngineGUI::init_imgui(window);
-	
-	ImGuiIO& io = ImGui::GetIO();
-	font = io.Fonts->AddFontFromFileTTF("assets/font/envy.ttf", 18);
-	io.Fonts->Build();
+	if (benchmark == nullptr) {
+		NoxEngineGUI::init_imgui(window);
 
-	// Initialize panel variables
-	NoxEngineGUI::initPresetObjectPanel();
+		ImGuiIO& io = ImGui::GetIO();
+		font = io.Fonts->AddFontFromFileTTF("assets/font/envy.ttf", 18);
+		io.Fonts->Build();
+
+		// Initialize panel variables
+		NoxEngineGUI::initPresetObjectPanel();
+	}
 
 	// Initialize gui params
 	ui_params.selectedEntity = -1;
@@ -448,6 +517,7 @@ void GameManager::init_postprocess() {
 	glBindVertexArray(0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::Instance()->invalidate();
 }
 
 
@@ -533,7 +603,7 @@ void GameManager::update_ecs() {
 	entityRemoved = nEntities != game_state.activeScene->entities.size();
 
 	// update subsystems if needed
-	if (/*updateRenderer && */entityRemoved) renderer->updateBuffers();
+	// Renderer: removed entities already gave their geometry back through componentRemoved
 	//if (updateAudioManager) audioManager->...
 
 	// Update done
@@ -571,6 +641,7 @@ void GameManager::update_gui() {
 	NoxEngineGUI::updatePresetObjectPanel(&game_state);
 	NoxEngineGUI::updateScenePanel(&game_state, &ui_params);
 	NoxEngineGUI::updateFullscreenShaderPanel(&game_state, &ui_params);
+	NoxEngineGUI::updateGpuProfilerPanel(&game_state);
 	
 	// Make sure the scene panel is focused when we run
 	if(ui_params.firstLoop) {
@@ -583,14 +654,16 @@ void GameManager::update_gui() {
 	ImGui::PopFont();
 	//ImGui::PopStyleVar();
 	ImGui::Render();
+}
 
+void GameManager::draw_gui() {
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
 
 void GameManager::update_audio() {
 
-	ITransform*		itrans	= nullptr;
+	TransformComponent* itrans = nullptr;
 	IAudioListener* ilisten = nullptr;
 	IAudioSource*	isrc	= nullptr;
 	IAudioGeometry* igeo	= nullptr;
@@ -607,11 +680,9 @@ void GameManager::update_audio() {
 			ilisten = game_state.activeAudioListener->getComp<AudioListenerComponent>();
 
 			if (itrans) {
-				mat4 rotation = glm::eulerAngleXYZ(itrans->rx, itrans->ry, itrans->rz);
-
 				pos		= vec3(itrans->x, itrans->y, itrans->z);
-				forward = rotation * vec4(forward, 1.0f);
-				up		= rotation * vec4(up, 1.0f);
+				forward = itrans->getForward();
+				up		= itrans->getUp();
 			}
 
 			if (ilisten) vel = ilisten->vVel;
@@ -638,11 +709,9 @@ void GameManager::update_audio() {
 
 		if (itrans && ent->isEnabled<TransformComponent>()) {
 
-			mat4 rotation = glm::eulerAngleXYZ(itrans->rx, itrans->ry, itrans->rz);
-
 			pos		= vec3(itrans->x, itrans->y, itrans->z);
-			forward = rotation * vec4(forward, 1.0f);
-			up		= rotation * vec4(up, 1.0f);
+			forward = itrans->getForward();
+			up		= itrans->getUp();
 			scale	= vec3(itrans->sx, itrans->sy, itrans->sz);
 		}
 
@@ -675,11 +744,34 @@ void GameManager::update_audio() {
 }
 
 
-void GameManager::update_animation() {
+void GameManager::update_transforms() {
 
+	// Everything that moves an entity this frame has run, rebuild the changed world matrices in one pass
+	transforms.clear();
+	for (Entity* ent : game_state.activeScene->entities) {
+		TransformComponent* trans = ent->getComp<TransformComponent>();
+		if (trans && trans->isDirty()) transforms.push_back(trans);
+	}
+
+	TransformComponent::updateWorldMatrices(transforms);
+}
+
+void GameManager::update_time() {
 	currentTime = glfwGetTime();
 	deltaTime = currentTime - lastTime;
 	lastTime = currentTime;
+}
+
+void GameManager::update_render_scale() {
+
+	// GPU time is what the resolution buys back, the frame time would include waiting for vsync
+	GpuProfiler *profiler = GpuProfiler::Instance();
+	f64 frameMs = profiler->isEnabled() ? profiler->getFrameMs() : deltaTime * 1000.0;
+
+	renderer->updateRenderScale(frameMs);
+}
+
+void GameManager::update_animation() {
 
 	for (Entity* ent : game_state.activeScene->entities) { 
 
@@ -691,7 +783,7 @@ void GameManager::update_animation() {
 	}
 }
 
-void GameManager::update_renderer() {
+void GameManager::update_renderer(const RenderPacket &packet) {
 
 	if(game_state.prev_win_width != game_state.win_width ||
 	   game_state.prev_win_height != game_state.win_height)
@@ -699,33 +791,11 @@ void GameManager::update_renderer() {
 		renderer->updateTextureSizes(game_state.win_width, game_state.win_height);
 	}
 
-	for(u32 i = 0; i < game_state.post_processors.size(); i++) {
-		if(game_state.prev_win_width != game_state.win_width ||
-			game_state.prev_win_height != game_state.win_height)
-		{
-			game_state.post_processors[i].changeTextureSize(game_state.win_width, game_state.win_height);
-		}
-	}
 
-
-	for (Entity* ent : game_state.activeScene->entities) {
-		if (ent->containsComps<RenderableComponent, AnimationComponent>())
-		{
-			RenderableComponent *rendComp = ent->getComp<RenderableComponent>();
-			AnimationComponent* animComp = ent->getComp<AnimationComponent>();
-			mat4 transformation = animComp->getTransformation();
-			renderer->updateObjectTransformation(transformation, rendComp->rendObjId);
-		}
-	}
-
-	for (u32 i = 0; i < renderer->getNumLights(); i++)
-	{
-		renderer->updateLightPos(i);
-	}
+	renderer->applyRenderPacket(packet);
 
 	renderer->setFrameBufferToTexture();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-	renderer->updateCamera();
 
 	renderer->setProgram(&programs[1]);
 	// maybe have a sun? 
@@ -738,6 +808,7 @@ void GameManager::update_renderer() {
 	//	renderer->updateLightPos(i, game_state.lightSources[i][0], game_state.lightSources[i][1], game_state.lightSources[i][2]);
 	renderer->fillBackground(ui_params.sceneBackgroundColor);
 	renderer->draw();
+	renderer->upscaleScene();
 
 	renderer->setFrameBufferToDefault();
 }
@@ -745,11 +816,19 @@ void GameManager::update_renderer() {
 
 void GameManager::update_postprocessors() {
 	if(ui_params.full_screen) {
-		glBindVertexArray(post_process_vao);
-		for(u32 i = 0; i < game_state.post_processors.size(); i++) {
-			if(game_state.post_processors[i].IsInit())
-				game_state.post_processors[i].draw(currentTime);
-		}
+		GpuProfileScope profile("Post processing");
+
+		GLStateCache::Instance()->bindVertexArray(post_process_vao);
+		game_state.post_process_chain.execute(game_state.post_processors, renderer->getTexture(),
+				game_state.fullscreen_shader_pass_used, game_state.win_width, game_state.win_height, currentTime);
+	}
+
+	// Pass outputs come from a pool, the shown texture has to be looked up again every frame
+	i32 shown = game_state.fullscreen_shader_pass_used;
+	if (shown >= 0 && shown < (i32)game_state.post_processors.size() && game_state.post_processors[shown].GetTexture() != 0) {
+		game_state.fullscreen_shader_texture_used = game_state.post_processors[shown].GetTexture();
+	} else {
+		game_state.fullscreen_shader_texture_used = renderer->getTexture();
 	}
 }
 
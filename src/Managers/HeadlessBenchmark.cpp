@@ -0,0 +1,233 @@
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <3rdParty/stb/stb_image_write.h>
+// The header has no guard around the implementation, Renderer.h includes it again
+#undef STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include <Managers/HeadlessBenchmark.h>
+#include <Core/GLStateCache.h>
+#include <Utils/Utils.h>
+
+#include <glm/gtc/constants.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+using namespace NoxEngine;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static const u32 DefaultCullBenchBoxes = 100000;
+static const u32 CullBenchQueries = 64;
+static const char *DefaultLodCheckPath = "assets/meshes/car.fbx";
+
+HeadlessBenchmark::HeadlessBenchmark(const BenchmarkSettings &settings) :
+	_settings(settings),
+	_frames(),
+	_frameStart(),
+	_frame(0)
+{
+	_frames.reserve(settings.frames);
+
+	if (!_settings.pngDirectory.empty()) {
+		std::error_code error;
+		std::filesystem::create_directories(_settings.pngDirectory, error);
+	}
+}
+
+bool HeadlessBenchmark::parseArgs(i32 argc, char **argv, BenchmarkSettings &settings) {
+
+	bool headless = false;
+
+	for (i32 i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (strcmp(arg, "--headless") == 0) headless = true;
+		else if (strcmp(arg, "--frames") == 0 && hasValue) settings.frames = (u32)atoi(argv[++i]);
+		else if (strcmp(arg, "--scene") == 0 && hasValue) settings.scenePath = argv[++i];
+		else if (strcmp(arg, "--csv") == 0 && hasValue) settings.csvPath = argv[++i];
+		else if (strcmp(arg, "--depth-prepass") == 0) settings.depthPrepass = true;
+		else if (strcmp(arg, "--occlusion") == 0) settings.occlusionCulling = true;
+		else if (strcmp(arg, "--overdraw") == 0) settings.showOverdraw = true;
+		else if (strcmp(arg, "--lod-error") == 0 && hasValue) settings.lodPixelError = (f32)atof(argv[++i]);
+		else if (strcmp(arg, "--cull-bench") == 0) {
+			settings.cullBenchBoxes = DefaultCullBenchBoxes;
+			// Optional box count
+			if (i + 1 < argc && argv[i + 1][0] != '-') settings.cullBenchBoxes = (u32)atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--lod-check") == 0) {
+			settings.lodCheckPath = DefaultLodCheckPath;
+			// Optional mesh file
+			if (i + 1 < argc && argv[i + 1][0] != '-') settings.lodCheckPath = argv[++i];
+		}
+		else if (strcmp(arg, "--size") == 0 && i + 2 < argc) {
+			settings.width = (u32)atoi(argv[++i]);
+			settings.height = (u32)atoi(argv[++i]);
+		}
+		else if (strcmp(arg, "--png") == 0 && hasValue) {
+			settings.pngDirectory = argv[++i];
+			// Optional interval after the directory
+			if (i + 1 < argc && argv[i + 1][0] != '-') settings.pngInterval = (u32)atoi(argv[++i]);
+		}
+		else LOG_DEBUG("Ignoring argument %s", arg);
+	}
+
+	if (settings.pngInterval == 0) settings.pngInterval = 1;
+
+	return headless;
+}
+
+bool HeadlessBenchmark::runCullBenchmark(u32 boxes) {
+
+	// Fixed seed, so runs compare across builds: boxes 1 to 10 units wide in a cube 2000 units across
+	std::mt19937 random(1);
+	std::uniform_real_distribution<f32> position(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<f32> extent(0.5f, 5.0f);
+
+	Array<AABB> bounds(boxes);
+	for (AABB &box : bounds) {
+		vec3 center(position(random), position(random), position(random));
+		vec3 extents(extent(random), extent(random), extent(random));
+		box = { center - extents, center + extents };
+	}
+
+	AABBTree tree;
+
+	auto start = Clock::now();
+	for (u32 i = 0; i < boxes; i++) tree.createProxy(bounds[i], i);
+	f64 buildMs = std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+
+	// The camera turns once around the centre of the cube, with the Renderer's projection
+	mat4 projection = glm::perspective(glm::radians(kFieldOfView), 16.0f / 9.0f, kNearPlane, kFarPlane);
+
+	Array<u32> treeVisible;
+	Array<u32> bruteVisible;
+	Array<u8> found(boxes, 0);
+	f64 treeMs = 0.0;
+	f64 bruteMs = 0.0;
+	u64 treeCount = 0;
+	u64 bruteCount = 0;
+	u32 missed = 0;
+
+	for (u32 q = 0; q < CullBenchQueries; q++) {
+		f32 angle = glm::two_pi<f32>() * (f32)q / (f32)CullBenchQueries;
+		Frustum frustum(projection * glm::lookAt(vec3(0.0f), vec3(std::cos(angle), 0.0f, std::sin(angle)), vec3(0.0f, 1.0f, 0.0f)));
+
+		treeVisible.clear();
+		start = Clock::now();
+		tree.query(frustum, treeVisible);
+		treeMs += std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+
+		bruteVisible.clear();
+		start = Clock::now();
+		for (u32 i = 0; i < boxes; i++) {
+			if (frustum.test(bounds[i]) != Frustum::Outside) bruteVisible.push_back(i);
+		}
+		bruteMs += std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+
+		// The tree tests the enlarged boxes of its leaves, it can return a few more but never fewer
+		for (u32 i : treeVisible) found[i] = 1;
+		for (u32 i : bruteVisible) missed += found[i] ? 0 : 1;
+		for (u32 i : treeVisible) found[i] = 0;
+
+		treeCount += treeVisible.size();
+		bruteCount += bruteVisible.size();
+	}
+
+	LOG_DEBUG("Cull benchmark: %u boxes, tree built in %.2f ms, height %d", boxes, buildMs, tree.getHeight());
+	LOG_DEBUG("Average of %u queries: tree %.3f ms for %.0f boxes, brute force %.3f ms for %.0f boxes, %.1fx faster",
+			CullBenchQueries, treeMs / CullBenchQueries, (f64)treeCount / CullBenchQueries,
+			bruteMs / CullBenchQueries, (f64)bruteCount / CullBenchQueries, bruteMs / std::max(treeMs, 1e-6));
+
+	if (missed > 0) LOG_DEBUG("The tree missed %u boxes inside the frustum", missed);
+
+	return missed == 0;
+}
+
+void HeadlessBenchmark::beginFrame(Camera *camera) {
+
+	f32 angle = glm::two_pi<f32>() * (f32)_frame / (f32)std::max(_settings.frames, 1u);
+	vec3 offset(std::cos(angle) * _settings.orbitRadius, _settings.orbitHeight, std::sin(angle) * _settings.orbitRadius);
+
+	camera->pos = _settings.orbitTarget + offset;
+	camera->forward = glm::normalize(-offset);
+	camera->up = vec3(0.0f, 1.0f, 0.0f);
+
+	_frameStart = std::chrono::high_resolution_clock::now();
+}
+
+void HeadlessBenchmark::endFrame(Renderer *renderer, const FramePacingStats &pacing) {
+
+	f64 frameMs = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - _frameStart).count();
+
+	const RenderStats &stats = renderer->getRenderStats();
+
+	const GLStateStats &binds = GLStateCache::Instance()->getCurrentStats();
+
+	_frames.push_back({
+		frameMs,
+		stats.submitMs,
+		stats.lightBinningMs,
+		stats.objectsDrawn,
+		stats.objectsCulled,
+		stats.objectsOccluded,
+		stats.drawCalls,
+		stats.trianglesDrawn,
+		stats.shadedPerPixel,
+		binds.bindsIssued,
+		binds.bindsSkipped,
+		pacing.simulationMs,
+		pacing.overlapMs
+	});
+
+	if (!_settings.pngDirectory.empty() && _frame % _settings.pngInterval == 0) writePng(renderer);
+
+	_frame++;
+}
+
+bool HeadlessBenchmark::writeCsv() const {
+
+	std::ofstream output(_settings.csvPath);
+	if (!output) {
+		LOG_DEBUG("Can't open %s for the benchmark results", _settings.csvPath.c_str());
+		return false;
+	}
+
+	output << "frame,frame_ms,submit_ms,light_binning_ms,objects_drawn,objects_culled,objects_occluded,draw_calls,triangles_drawn,shaded_per_pixel,binds_issued,binds_skipped,simulation_ms,overlap_ms\n";
+
+	f64 total = 0.0;
+	for (u32 i = 0; i < _frames.size(); i++) {
+		const BenchmarkFrame &f = _frames[i];
+		output << i << ',' << f.frameMs << ',' << f.submitMs << ',' << f.lightBinningMs << ','
+			<< f.objectsDrawn << ',' << f.objectsCulled << ',' << f.objectsOccluded << ',' << f.drawCalls << ',' << f.trianglesDrawn << ',' << f.shadedPerPixel << ','
+			<< f.bindsIssued << ',' << f.bindsSkipped << ',' << f.simulationMs << ',' << f.overlapMs << '\n';
+		total += f.frameMs;
+	}
+
+	LOG_DEBUG("Benchmark: %u frames, %.3f ms average, results in %s", (u32)_frames.size(),
+			_frames.empty() ? 0.0 : total / _frames.size(), _settings.csvPath.c_str());
+
+	return true;
+}
+
+void HeadlessBenchmark::writePng(Renderer *renderer) const {
+
+	u32 width = _settings.width;
+	u32 height = _settings.height;
+
+	Array<u8> pixels(width * height * 4);
+	glGetTextureImage(renderer->getTexture(), 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)pixels.size(), pixels.data());
+
+	char path[512];
+	snprintf(path, sizeof(path), "%s/frame_%05u.png", _settings.pngDirectory.c_str(), _frame);
+
+	// GL rows start at the bottom
+	stbi_flip_vertically_on_write(1);
+	if (!stbi_write_png(path, width, height, 4, pixels.data(), width * 4)) {
+		LOG_DEBUG("Failed to write %s", path);
+	}
+}
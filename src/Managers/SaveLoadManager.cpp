@@ -72,9 +72,8 @@ void NoxEngine::saveScene(std::string file_path, NoxEngine::GameState& game_stat
 						outputStream.write((char*)&meshNameSize, sizeof(meshNameSize));
 						outputStream.write((char*)meshName.c_str(), meshNameSize);
 
-						for (const auto itr : game_state.renderer->getObjects()) 
+						for (const RendObj &obj : game_state.renderer->getObjects()) 
 						{
-							RendObj obj = itr.second;
 							if (obj.ent == ent)
 							{
 								std::string ambientTexture(obj.ambientTexturePath);
@@ -222,8 +221,10 @@ void NoxEngine::loadScene(std::string file_path, NoxEngine::GameState& game_stat
 				{
 					if (loadedFromFile)
 					{
-						if(game_state.meshScenes.find(fbx_filepath) == game_state.meshScenes.end())
-							game_state.meshScenes.emplace(fbx_filepath, NoxEngine::readFBX(fbx_filepath.c_str()));
+						if(game_state.meshScenes.find(fbx_filepath) == game_state.meshScenes.end()) {
+							auto inserted = game_state.meshScenes.emplace(fbx_filepath, NoxEngine::readFBX(fbx_filepath.c_str()));
+							inserted.first->second.setGeometryKeys(fbx_filepath);
+						}
 						MeshScene& meshScene = game_state.meshScenes.find(fbx_filepath)->second;
 
 						std::string meshName;
@@ -0,0 +1,142 @@
+#include <PostProcessChain.h>
+#include <Core/GpuProfiler.h>
+#include <Core/GLStateCache.h>
+#include <Utils/Utils.h>
+
+#include <algorithm>
+
+using namespace NoxEngine;
+
+PostProcessChain::PostProcessChain() :
+	_targets(),
+	_lastReader(),
+	_inputTextures(),
+	_frame(0),
+	_keepOutputs(false),
+	_stats()
+{
+}
+
+PostProcessChain::~PostProcessChain() {
+	clear();
+}
+
+void PostProcessChain::clear() {
+	for (RenderTarget &target : _targets) {
+		glDeleteFramebuffers(1, &target.framebuffer);
+		glDeleteTextures(1, &target.texture);
+	}
+
+	_targets.clear();
+}
+
+void PostProcessChain::execute(Array<FullscreenShader> &passes, u32 sceneTexture, i32 shownPass, u32 width, u32 height, time_type time) {
+
+	_frame++;
+
+	u32 passCount = (u32)passes.size();
+	i32 pastTheEnd = (i32)passCount;
+
+	// Last pass reading each output, inputs from later passes are ignored since those haven't run yet
+	_lastReader.assign(passCount, _keepOutputs ? pastTheEnd : -1);
+	for (u32 i = 0; i < passCount; i++) {
+		for (const TextureInput &input : passes[i].GetTextureInputs()) {
+			if (input.source >= 0 && input.source < (i32)i) _lastReader[input.source] = std::max(_lastReader[input.source], (i32)i);
+		}
+	}
+
+	if (shownPass >= 0 && shownPass < pastTheEnd) _lastReader[shownPass] = pastTheEnd;
+
+	for (RenderTarget &target : _targets) target.lastReader = -1;
+
+	_stats.passesRun = 0;
+	_stats.passesSkipped = 0;
+
+	for (u32 i = 0; i < passCount; i++) {
+		FullscreenShader &pass = passes[i];
+
+		if (!pass.IsInit() || _lastReader[i] < 0) {
+			if (pass.IsInit()) _stats.passesSkipped++;
+			pass.setOutput(0, 0, 0, 0);
+			continue;
+		}
+
+		u32 passWidth = std::max((u32)(width * pass.GetResolutionScale()), 1u);
+		u32 passHeight = std::max((u32)(height * pass.GetResolutionScale()), 1u);
+
+		const RenderTarget &target = _targets[acquire(passWidth, passHeight, (i32)i, _lastReader[i])];
+		pass.setOutput(target.framebuffer, target.texture, target.width, target.height);
+
+		_inputTextures.clear();
+		for (const TextureInput &input : pass.GetTextureInputs()) {
+			if (input.source == kMainRendererInput) _inputTextures.push_back(sceneTexture);
+			else if (input.source >= 0 && input.source < (i32)i) _inputTextures.push_back(passes[input.source].GetTexture());
+			else _inputTextures.push_back(0);
+		}
+
+		GpuProfileScope passProfile(pass.GetName());
+		pass.draw(time, _inputTextures);
+		_stats.passesRun++;
+	}
+
+	// Passes set their own viewport, the rest of the frame expects the full size
+	glViewport(0, 0, width, height);
+
+	trim();
+
+	_stats.targets = (u32)_targets.size();
+	_stats.pooledBytes = 0;
+	for (const RenderTarget &target : _targets) _stats.pooledBytes += (u64)target.width * target.height * 4;
+	_stats.perPassBytes = (u64)passCount * width * height * 4;
+}
+
+u32 PostProcessChain::acquire(u32 width, u32 height, i32 pass, i32 lastReader) {
+
+	// Free once every pass reading it has run, the same order every frame gives the same targets
+	for (u32 i = 0; i < _targets.size(); i++) {
+		RenderTarget &target = _targets[i];
+		if (target.width != width || target.height != height || target.lastReader >= pass) continue;
+
+		target.lastReader = lastReader;
+		target.lastUsedFrame = _frame;
+		return i;
+	}
+
+	RenderTarget target = { 0, 0, width, height, lastReader, _frame };
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &target.texture);
+	glTextureStorage2D(target.texture, 1, GL_RGBA8, width, height);
+	glTextureParameteri(target.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(target.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(target.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(target.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glCreateFramebuffers(1, &target.framebuffer);
+	glNamedFramebufferTexture(target.framebuffer, GL_COLOR_ATTACHMENT0, target.texture, 0);
+
+	if (glCheckNamedFramebufferStatus(target.framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_DEBUG("Failed to build a %ux%u post-processing target", width, height);
+	}
+
+	_targets.push_back(target);
+	return (u32)_targets.size() - 1;
+}
+
+void PostProcessChain::trim() {
+
+	u32 i = 0;
+	while (i < _targets.size()) {
+		RenderTarget &target = _targets[i];
+		if (_frame - target.lastUsedFrame <= TargetLifetime) {
+			i++;
+			continue;
+		}
+
+		// Unused for frames, no texture id the GUI recorded can still point at it
+		glDeleteFramebuffers(1, &target.framebuffer);
+		glDeleteTextures(1, &target.texture);
+		GLStateCache::Instance()->invalidate();
+
+		_targets.erase(_targets.begin() + i);
+	}
+}
@@ -8,6 +8,9 @@
 
 #include <glm/gtx/string_cast.hpp>
 #include <Utils/Utils.h>
+#include <Core/MeshSimplifier.h>
+
+#include <filesystem>
 
 using NoxEngineUtils::Logger;
 
@@ -56,6 +59,104 @@ const aiScene* NoxEngine::readFBX(const char* filename)
 	}
 }
 
+void NoxEngine::reportVertexCache(const char* directory)
+{
+	std::error_code error;
+	std::filesystem::directory_iterator files(directory, error);
+	if (error) {
+		Logger::debug("Can't list '%s' for the vertex cache report", directory);
+		return;
+	}
+
+	VertexCacheStats total = {};
+
+	for (const std::filesystem::directory_entry& entry : files) {
+		if (entry.path().extension() != ".fbx") continue;
+
+		String path = entry.path().string();
+		const aiScene* pScene = readFBX(path.c_str());
+		if (!pScene) continue;
+
+		MeshScene scene(pScene);
+		const VertexCacheStats& stats = scene.vertexCacheStats;
+		Logger::debug("%s: %u triangles, ACMR %.3f -> %.3f", path.c_str(), stats.triangles, stats.acmrBefore, stats.acmrAfter);
+
+		total.triangles += stats.triangles;
+		total.acmrBefore += stats.acmrBefore * stats.triangles;
+		total.acmrAfter += stats.acmrAfter * stats.triangles;
+
+		for (Mesh* mesh : scene.meshes) delete mesh;
+		delete pScene;
+	}
+
+	if (total.triangles > 0) {
+		Logger::debug("All meshes: %u triangles, ACMR %.3f -> %.3f", total.triangles,
+				total.acmrBefore / total.triangles, total.acmrAfter / total.triangles);
+	}
+}
+
+bool NoxEngine::checkLods(const char* path)
+{
+	const aiScene* pScene = readFBX(path);
+	if (!pScene) return false;
+
+	MeshScene scene(pScene);
+
+	bool passed = true;
+	u32 meshesWithLods = 0;
+
+	for (Mesh* mesh : scene.meshes) {
+		const Array<LodLevel>& lods = mesh->getLods();
+		if (lods.empty()) continue;
+
+		meshesWithLods++;
+
+		f32 bound = lodErrorBound(mesh->getVertices());
+		u32 previousCount = mesh->use_indices ? (u32)mesh->getIndices().size() / 3 : (u32)mesh->getFaces().size();
+		f32 previousError = 0.0f;
+
+		char levels[512];
+		i32 length = snprintf(levels, sizeof(levels), "%u", previousCount);
+
+		for (u32 i = 0; i < lods.size(); i++) {
+			u32 count = (u32)lods[i].indices.size() / 3;
+			f32 ratio = (f32)count / previousCount;
+			bool last = i + 1 == lods.size();
+
+			// The last level may be held back by the error bound or the open edges, still a quarter smaller
+			bool halved = (ratio >= 0.4f && ratio <= 0.6f) || (last && ratio <= 0.75f);
+			bool withinBound = lods[i].error >= previousError && lods[i].error <= bound * 1.0001f;
+
+			if (!halved || !withinBound) {
+				Logger::debug("%s, mesh '%s' level %u: %u -> %u triangles, error %f after %f, bound %f", path, mesh->name.c_str(),
+						i + 1, previousCount, count, lods[i].error, previousError, bound);
+				passed = false;
+			}
+
+			if (length > 0 && length < (i32)sizeof(levels)) {
+				length += snprintf(levels + length, sizeof(levels) - length, " -> %u (error %.4f)", count, lods[i].error);
+			}
+
+			previousCount = count;
+			previousError = lods[i].error;
+		}
+
+		Logger::debug("%s, mesh '%s': %s triangles, error bound %.4f", path, mesh->name.c_str(), levels, bound);
+	}
+
+	if (meshesWithLods == 0) {
+		Logger::debug("%s: no mesh got LODs", path);
+		passed = false;
+	}
+
+	Logger::debug("%s: LOD check %s", path, passed ? "passed" : "failed");
+
+	for (Mesh* mesh : scene.meshes) delete mesh;
+	delete pScene;
+
+	return passed;
+}
+
 aiScene* NoxEngine::generateAiScene(const MeshScene& meshScene)
 {
 	aiScene *scene = new aiScene();
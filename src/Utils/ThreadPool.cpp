@@ -0,0 +1,71 @@
+#include <Utils/ThreadPool.h>
+
+#include <algorithm>
+
+using namespace NoxEngine;
+
+ThreadPool::ThreadPool(u32 threadCount) :
+	_threads(),
+	_jobs(),
+	_mutex(),
+	_condition(),
+	_stopping(false)
+{
+	if (threadCount == 0) {
+		u32 hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = std::max(hardwareThreads, 2u) - 1;
+	}
+
+	for (u32 i = 0; i < threadCount; i++) {
+		_threads.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	shutdown();
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_stopping) return;
+		_jobs.push_back(std::move(job));
+	}
+
+	_condition.notify_one();
+}
+
+void ThreadPool::shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+		_jobs.clear();
+	}
+
+	_condition.notify_all();
+
+	for (std::thread &thread : _threads) {
+		if (thread.joinable()) thread.join();
+	}
+
+	_threads.clear();
+}
+
+void ThreadPool::workerLoop() {
+
+	while (true) {
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+
+			if (_stopping) return;
+
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		job();
+	}
+}
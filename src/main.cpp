@@ -2,11 +2,23 @@
 
 // Engine Include
 #include <Managers/GameManager.h>
+#include <Managers/HeadlessBenchmark.h>
+#include <Utils/FBXFileLoader.h>
 #include <Utils/Utils.h>
 using NoxEngine::GameManager;
 int main(int argc, char** argv) {
 
 	GameManager *gm = GameManager::Instance();
+
+	NoxEngine::BenchmarkSettings benchmark;
+	bool headless = NoxEngine::HeadlessBenchmark::parseArgs(argc, argv, benchmark);
+
+	// CPU only, runs before anything opens a window
+	if (benchmark.cullBenchBoxes > 0) return NoxEngine::HeadlessBenchmark::runCullBenchmark(benchmark.cullBenchBoxes) ? 0 : 1;
+	if (!benchmark.lodCheckPath.empty()) return NoxEngine::checkLods(benchmark.lodCheckPath.c_str()) ? 0 : 1;
+
+	if (headless) gm->setHeadless(benchmark);
+
 	gm->init();
 	while(gm->KeepRunning()) {
 		gm->update();